@@ -7,6 +7,7 @@
 #include <fstream>
 #include <vector>
 #include <sstream>
+#include <cstring>
 
 using namespace std;
 
@@ -18,6 +19,12 @@ WINDOW *header_win;
 WINDOW *race_win;
 WINDOW *control_win;
 
+// --- Track Layout (computed in initNcurses from NUM_RACERS and the screen size) ---
+int track_row_spacing = 2;  // Rows per racer (2 for small races, 1 when packing many racers)
+int visible_racers = 0;     // How many racer rows fit in race_win
+int scroll_offset = 0;      // Index of the first racer shown
+int track_lane = 0;         // Race (arena block) the track view shows, with --concurrent
+
 // --- INITIALIZATION AND DRAWING ---
 
 /**
@@ -56,11 +63,27 @@ void initNcurses() {
     // Header Window
     header_win = newwin(3, max_x, 0, 0);
 
-    // Race Window
+    // Race Window: grows with NUM_RACERS until it runs out of screen rows,
+    // after which the track scrolls (see scrollRaceTrackGUI)
+    int race_win_y = 3;
+    int max_race_win_height = max_y - race_win_y - 6;
+    if (max_race_win_height < 6) max_race_win_height = 6;
+
     int race_win_height = 8 + NUM_RACERS * 2;
+    if (race_win_height > max_race_win_height) {
+        race_win_height = max_race_win_height;
+    }
+
+    // Row 1 holds the summary line, the bottom border takes the last row
+    int track_rows = race_win_height - 4;
+    track_row_spacing = (NUM_RACERS * 2 <= track_rows) ? 2 : 1;
+    visible_racers = track_rows / track_row_spacing;
+    if (visible_racers > NUM_RACERS) visible_racers = NUM_RACERS;
+    scroll_offset = 0;
+
     int race_win_width = RACE_LENGTH_DISPLAY + 45;
-    int race_win_y = 3;
     int race_win_x = (max_x - race_win_width) / 2;
+    if (race_win_x < 0) race_win_x = 0;
     race_win = newwin(race_win_height, race_win_width, race_win_y, race_win_x);
 
     // Control/Status Window
@@ -77,75 +100,139 @@ void endNcurses() {
     endwin();
 }
 
+/**
+ * @brief Scrolls the race track by delta racers (clamped to the valid range).
+ */
+void scrollRaceTrackGUI(int delta) {
+    int max_offset = NUM_RACERS - visible_racers;
+    scroll_offset += delta;
+    if (scroll_offset > max_offset) scroll_offset = max_offset;
+    if (scroll_offset < 0) scroll_offset = 0;
+}
+
+// --- Frame Cache ---
+// What the track view last put on screen. drawRaceTrackGUI() diffs shared memory
+// against it and only rewrites what changed; anything that moves the layout
+// (view switch, scroll, terminal resize) invalidates it for one full redraw.
+struct TrackFrame {
+    bool valid = false;
+    int scroll_offset = 0;
+    int screen_y = 0, screen_x = 0;
+    int status = -1;
+    int winner_id = -1;
+    string status_text;
+    uint64_t seed = 0;
+    string summary;
+    vector<int> pid;          // Per visible row
+    vector<int> position;     // Raw position (drives the "pos / length" text)
+    vector<int> pos_display;  // Position in track cells
+    vector<int> dnf;          // Racer died mid-race (RacerSlot::dnf)
+};
+static TrackFrame drawn;
 
 /**
- * @brief Draws the main race track and control buttons (TUI Menu).
+ * @brief Selects the race the track view follows; switching races redraws it in full.
  */
-void drawRaceTrackGUI(int* shm_ptr, int winner_id, int current_view) {
-    int max_y, max_x;
-    getmaxyx(stdscr, max_y, max_x);
+void setTrackLane(int lane) {
+    if (lane != track_lane) {
+        track_lane = lane;
+        drawn.valid = false;
+    }
+}
 
-    wclear(header_win);
-    wclear(race_win);
-    wclear(control_win);
-    box(race_win, 0, 0); // Draw border
+// Replaces the status line of the track view while non-empty (used by --replay)
+static string status_override;
 
-    // --- Header Content ---
-    wattron(header_win, A_BOLD | COLOR_PAIR(12));
-    mvwprintw(header_win, 1, 2, " C++ Multiprocess Race Simulator (NCURSES TUI) ");
-    wattroff(header_win, A_BOLD | COLOR_PAIR(12));
-    mvwprintw(header_win, 2, 2, "Race Length: %d | Track Width: %d chars", RACE_LENGTH, RACE_LENGTH_DISPLAY);
-    mvwprintw(header_win, 2, max_x - 30, "PID of Monitor: %d", getpid());
+void setTrackStatusOverride(const string& text) {
+    status_override = text;
+}
 
+const char* CAR_ICON = "(O=)";
+const int CAR_ICON_WIDTH = 4;
 
-    // --- Race Window Content (Track and Racers) ---
+/**
+ * @brief Formats the one-line aggregate view (leader, average, finishers) above the track.
+ */
+static string formatRaceSummary(const RaceSnapshot& snap) {
+    int leader = 0;
+    long total = 0;
+    int finished = 0;
     for (int i = 0; i < NUM_RACERS; ++i) {
-        int racer_id = i + 1;
-        int pos_100 = shm_ptr[POS_OFFSET + i];
-        int pid = shm_ptr[PID_OFFSET + i];
-
-        int pos_display = (pos_100 * RACE_LENGTH_DISPLAY) / RACE_LENGTH;
-        int y_pos = 2 + i * 2;
-        string car_icon = "(O=)";
-
-        // 1. Print Status and PID
-        wattron(race_win, COLOR_PAIR(13) | A_BOLD);
-        mvwprintw(race_win, y_pos, 2, "Racer %d [PID: %d]:", racer_id, pid);
-        wattroff(race_win, COLOR_PAIR(13) | A_BOLD);
-
-        // 2. Print Track Start/End markers
-        mvwaddch(race_win, y_pos, 23, '[');
-
-        // Draw the Finish Line
-        wattron(race_win, COLOR_PAIR(7) | A_BOLD);
-        mvwaddch(race_win, y_pos, 24 + RACE_LENGTH_DISPLAY, ']'); // Using ']' as the finish line end
-        wattroff(race_win, COLOR_PAIR(7) | A_BOLD);
-
-        // 3. Draw Progress
-        wattron(race_win, COLOR_PAIR(racer_id));
-        for (int j = 0; j <= RACE_LENGTH_DISPLAY; ++j) { // Go up to RACE_LENGTH_DISPLAY to handle 100% position
-            if (j < pos_display) {
-                mvwaddch(race_win, y_pos, 24 + j, ACS_CKBOARD); // Traveled segment
-            } else if (j == pos_display && pos_100 < RACE_LENGTH) {
-                // Draw the active racer icon (car)
-                mvwprintw(race_win, y_pos, 24 + j, "%s", car_icon.c_str());
-            } else if (j > pos_display && j < RACE_LENGTH_DISPLAY) {
-                wattron(race_win, COLOR_PAIR(13));
-                mvwaddch(race_win, y_pos, 24 + j, ACS_HLINE); // Remaining track space
-                wattroff(race_win, COLOR_PAIR(13));
-            }
+        int pos = snap.racers[i].position;
+        total += pos;
+        if (pos >= RACE_LENGTH) finished++;
+        if (pos > snap.racers[leader].position) leader = i;
+    }
+
+    char dnf_text[32] = "";
+    if (snap.dnf_count > 0) snprintf(dnf_text, sizeof(dnf_text), " | DNF: %d", snap.dnf_count);
+
+    char line[256];
+    snprintf(line, sizeof(line), "Racers %d-%d of %d | Leader: Racer %d (%d) | Avg: %ld | At finish: %d%s%s",
+             scroll_offset + 1, scroll_offset + visible_racers, NUM_RACERS,
+             leader + 1, snap.racers[leader].position, total / NUM_RACERS, finished, dnf_text,
+             visible_racers < NUM_RACERS ? " | Up/Down/PgUp/PgDn" : "");
+    return line;
+}
+
+/**
+ * @brief Draws track cells [from, to] of one racer row.
+ */
+static void drawTrackCells(int y_pos, int racer_pair, int pos_display, bool finished, int from, int to) {
+    if (from < 0) from = 0;
+    if (to > RACE_LENGTH_DISPLAY - 1) to = RACE_LENGTH_DISPLAY - 1;
+
+    for (int j = from; j <= to; ++j) {
+        if (j < pos_display) {
+            wattron(race_win, COLOR_PAIR(racer_pair));
+            mvwaddch(race_win, y_pos, 24 + j, ACS_CKBOARD); // Traveled segment
+            wattroff(race_win, COLOR_PAIR(racer_pair));
+        } else if (!finished && j < pos_display + CAR_ICON_WIDTH) {
+            // The active racer icon (car), clipped at the finish line
+            wattron(race_win, COLOR_PAIR(racer_pair));
+            mvwaddch(race_win, y_pos, 24 + j, CAR_ICON[j - pos_display]);
+            wattroff(race_win, COLOR_PAIR(racer_pair));
+        } else {
+            wattron(race_win, COLOR_PAIR(13));
+            mvwaddch(race_win, y_pos, 24 + j, ACS_HLINE); // Remaining track space
+            wattroff(race_win, COLOR_PAIR(13));
         }
-        wattroff(race_win, COLOR_PAIR(racer_id));
+    }
+}
 
-        // 4. Print Percentage
-        mvwprintw(race_win, y_pos, 30 + RACE_LENGTH_DISPLAY, "%3d / %d", pos_100, RACE_LENGTH);
+static void drawRacerLabel(int y_pos, int racer_id, int pid) {
+    // Compact label once ids/PIDs no longer fit the label column
+    char label[64];
+    snprintf(label, sizeof(label), "Racer %d [PID: %d]:", racer_id, pid);
+    if (strlen(label) > 21) {
+        snprintf(label, sizeof(label), "#%d [%d]:", racer_id, pid);
     }
+    wattron(race_win, COLOR_PAIR(13) | A_BOLD);
+    mvwprintw(race_win, y_pos, 2, "%-21.21s", label);
+    wattroff(race_win, COLOR_PAIR(13) | A_BOLD);
+}
 
-    // --- Control and Status Window ---
-    int status = shm_ptr[STATUS_INDEX];
-    string status_text;
+static void drawHeader(int max_x, uint64_t seed) {
+    werase(header_win);
+    wattron(header_win, A_BOLD | COLOR_PAIR(12));
+    mvwprintw(header_win, 1, 2, " C++ Multiprocess Race Simulator (NCURSES TUI) ");
+    wattroff(header_win, A_BOLD | COLOR_PAIR(12));
+    mvwprintw(header_win, 2, 2, "Race Length: %d | Track Width: %d chars | Seed: %llu",
+              RACE_LENGTH, RACE_LENGTH_DISPLAY, (unsigned long long)seed);
+    mvwprintw(header_win, 2, max_x - 30, "PID of Monitor: %d", getpid());
+    if (CONCURRENT_RACES > 1) {
+        mvwprintw(header_win, 1, max_x - 30, "Race %d of %d | B: grid", track_lane + 1, CONCURRENT_RACES);
+    }
+}
 
-    switch (status) {
+/**
+ * @brief Draws the status line and control buttons (only called when the status changes).
+ */
+static void drawControls(int status, int winner_id, int max_x) {
+    werase(control_win);
+
+    string status_text = status_override;
+    if (status_text.empty()) switch (status) {
         case READY:
             status_text = "RACE READY. Press 'S' to START the processes.";
             break;
@@ -156,7 +243,9 @@ void drawRaceTrackGUI(int* shm_ptr, int winner_id, int current_view) {
             status_text = "RACE PAUSED. Press 'S' to RESUME, or 'Q' to EXIT.";
             break;
         case FINISHED:
-            status_text = "RACE FINISHED! Winner: Racer " + to_string(winner_id) + ". Press 'S' to reset or 'R' for results.";
+            status_text = winner_id > 0 ? "RACE FINISHED! Winner: Racer " + to_string(winner_id) + "."
+                                        : "RACE FINISHED! No racer crossed the line.";
+            status_text += " Press 'S' to reset or 'R' for results.";
             break;
         case EXITING:
             status_text = "EXITING...";
@@ -171,8 +260,8 @@ void drawRaceTrackGUI(int* shm_ptr, int winner_id, int current_view) {
     // --- Draw Buttons (Centered) ---
 
     // Define Button Texts and Widths
-    string btn_s, btn_p, btn_r, btn_q;
-    int pair_s, pair_p, pair_r, pair_q;
+    string btn_s, btn_p, btn_r, btn_t, btn_a, btn_q;
+    int pair_s, pair_p, pair_r, pair_t, pair_a, pair_q;
 
     // 1. START/RESUME Button (S)
     if (status == READY || status == FINISHED || status == PAUSED) {
@@ -196,13 +285,22 @@ void drawRaceTrackGUI(int* shm_ptr, int winner_id, int current_view) {
     btn_r = " R: RESULTS ";
     pair_r = COLOR_PAIR(11); // Cyan (Active)
 
-    // 4. EXIT Button (Q)
+    // 4. STATS Button (T)
+    btn_t = " T: STATS ";
+    pair_t = COLOR_PAIR(11); // Cyan (Active)
+
+    // 5. ANALYTICS Button (A)
+    btn_a = " A: ANALYTICS ";
+    pair_a = COLOR_PAIR(11); // Cyan (Active)
+
+    // 6. EXIT Button (Q)
     btn_q = " Q: EXIT ";
     pair_q = COLOR_PAIR(10); // Red (Active)
 
 
     // Calculate total button width and starting X position to center
-    int total_width = btn_s.length() + btn_p.length() + btn_r.length() + btn_q.length() + (3 * 3); // 3 spaces between 4 buttons
+    int total_width = btn_s.length() + btn_p.length() + btn_r.length() + btn_t.length() + btn_a.length() +
+                      btn_q.length() + (5 * 3); // 3 spaces between 6 buttons
     int start_x = (max_x - total_width) / 2;
     int current_x = start_x;
 
@@ -224,59 +322,333 @@ void drawRaceTrackGUI(int* shm_ptr, int winner_id, int current_view) {
     wattroff(control_win, pair_r | A_BOLD);
     current_x += btn_r.length() + 3;
 
+    // Draw T Button
+    wattron(control_win, pair_t | A_BOLD);
+    mvwprintw(control_win, 3, current_x, "%s", btn_t.c_str());
+    wattroff(control_win, pair_t | A_BOLD);
+    current_x += btn_t.length() + 3;
+
+    // Draw A Button
+    wattron(control_win, pair_a | A_BOLD);
+    mvwprintw(control_win, 3, current_x, "%s", btn_a.c_str());
+    wattroff(control_win, pair_a | A_BOLD);
+    current_x += btn_a.length() + 3;
+
     // Draw Q Button
     wattron(control_win, pair_q | A_BOLD);
     mvwprintw(control_win, 3, current_x, "%s", btn_q.c_str());
     wattroff(control_win, pair_q | A_BOLD);
+}
+
+/**
+ * @brief Draws the main race track and control buttons (TUI Menu).
+ *        Only the parts that differ from the previous frame are rewritten, and all
+ *        windows go out in a single doupdate().
+ */
+void drawRaceTrackGUI(RaceShm* shm, int winner_id) {
+    int max_y, max_x;
+    getmaxyx(stdscr, max_y, max_x);
+
+    bool full = !drawn.valid || drawn.scroll_offset != scroll_offset ||
+                drawn.screen_y != max_y || drawn.screen_x != max_x;
+    if (full) {
+        werase(race_win);
+        box(race_win, 0, 0); // Draw border
+
+        drawn.valid = true;
+        drawn.scroll_offset = scroll_offset;
+        drawn.screen_y = max_y;
+        drawn.screen_x = max_x;
+        drawn.status = -1;
+        drawn.winner_id = -1;
+        drawn.seed = ~shm->race_seed;
+        drawn.summary.clear();
+        drawn.pid.assign(visible_racers, -1);
+        drawn.position.assign(visible_racers, -1);
+        drawn.pos_display.assign(visible_racers, -1);
+        drawn.dnf.assign(visible_racers, 0);
+    }
+
+    // Header: static apart from the seed, which changes with every race
+    if (shm->race_seed != drawn.seed) {
+        drawHeader(max_x, shm->race_seed);
+        drawn.seed = shm->race_seed;
+    }
+
+    // --- Race Window Content (Track and Racers) ---
+    // One snapshot per frame: summary, rows and status all show the same instant
+    static RaceSnapshot snap;
+    takeRaceSnapshot(shm, snap);
+    string summary = formatRaceSummary(snap);
+    if (summary != drawn.summary) {
+        int width = getmaxx(race_win) - 4; // Pad over the previous text, stop at the border
+        wattron(race_win, COLOR_PAIR(6));
+        mvwprintw(race_win, 1, 2, "%-*.*s", width, width, summary.c_str());
+        wattroff(race_win, COLOR_PAIR(6));
+        drawn.summary = summary;
+    }
+
+    for (int row = 0; row < visible_racers; ++row) {
+        int i = scroll_offset + row;
+        int racer_id = i + 1;
+        int racer_pair = ((racer_id - 1) % 4) + 1; // Racer colors repeat every 4 racers
+        const RacerSnapshot& racer = snap.racers[i];
+        int pos_100 = racer.position;
+        int pid = racer.pid;
+        int dnf = racer.dnf;
+
+        int pos_display = (int)(((long)pos_100 * RACE_LENGTH_DISPLAY) / RACE_LENGTH);
+        if (pos_display > RACE_LENGTH_DISPLAY) pos_display = RACE_LENGTH_DISPLAY;
+        int y_pos = 2 + row * track_row_spacing;
+
+        // 1. Status and PID
+        if (pid != drawn.pid[row]) {
+            drawRacerLabel(y_pos, racer_id, pid);
+            drawn.pid[row] = pid;
+        }
 
-    wrefresh(header_win);
-    wrefresh(race_win);
-    wrefresh(control_win);
+        if (pos_100 == drawn.position[row] && dnf == drawn.dnf[row]) continue;
+
+        // How old the step is by the time it reaches the screen
+        if (racer.last_step_us != 0 && drawn.position[row] != -1 && pos_100 != drawn.position[row]) {
+            recordLatency(&raceStats(shm)->hist[HIST_STEP_TO_DRAW], monotonic_us() - racer.last_step_us);
+        }
+
+        // 2. Track: first draw covers the whole row, later frames only the cells between
+        //    the old and new car position (including both icons)
+        if (drawn.position[row] == -1) {
+            mvwaddch(race_win, y_pos, 23, '[');
+            wattron(race_win, COLOR_PAIR(7) | A_BOLD);
+            mvwaddch(race_win, y_pos, 24 + RACE_LENGTH_DISPLAY, ']'); // Using ']' as the finish line end
+            wattroff(race_win, COLOR_PAIR(7) | A_BOLD);
+            drawTrackCells(y_pos, racer_pair, pos_display, pos_100 >= RACE_LENGTH, 0, RACE_LENGTH_DISPLAY - 1);
+        } else {
+            int old_display = drawn.pos_display[row];
+            int from = old_display < pos_display ? old_display : pos_display;
+            int to = (old_display > pos_display ? old_display : pos_display) + CAR_ICON_WIDTH - 1;
+            drawTrackCells(y_pos, racer_pair, pos_display, pos_100 >= RACE_LENGTH, from, to);
+        }
+
+        // 3. Percentage (a racer whose process died is frozen there and flagged)
+        mvwprintw(race_win, y_pos, 30 + RACE_LENGTH_DISPLAY, "%3d / %d%s", pos_100, RACE_LENGTH, dnf ? " DNF" : "    ");
+
+        drawn.position[row] = pos_100;
+        drawn.pos_display[row] = pos_display;
+        drawn.dnf[row] = dnf;
+    }
+
+    // --- Control and Status Window ---
+    int status = snap.status;
+    if (status != drawn.status || winner_id != drawn.winner_id || status_override != drawn.status_text) {
+        drawControls(status, winner_id, max_x);
+        drawn.status = status;
+        drawn.winner_id = winner_id;
+        drawn.status_text = status_override;
+    }
+
+    wnoutrefresh(header_win);
+    wnoutrefresh(race_win);
+    wnoutrefresh(control_win);
+    doupdate();
 }
 
 /**
  * @brief Draws the results history screen.
  */
 void drawResultsGUI() {
-    int max_y, max_x;
-    getmaxyx(stdscr, max_y, max_x);
+    int max_x = getmaxx(stdscr);
+
+    // This view reuses the track windows; the track view redraws in full when it comes back
+    drawn.valid = false;
 
-    wclear(header_win);
-    wclear(race_win);
-    wclear(control_win);
+    // werase (not wclear) so curses still only sends the cells that differ
+    werase(header_win);
+    werase(race_win);
+    werase(control_win);
     box(race_win, 0, 0);
 
     wattron(header_win, A_BOLD | COLOR_PAIR(12));
     mvwprintw(header_win, 1, 2, " RACE HISTORY & RESULTS ");
     wattroff(header_win, A_BOLD | COLOR_PAIR(12));
-    mvwprintw(header_win, 2, 2, "File: race_results.txt | Press 'B' to go back.");
+    mvwprintw(header_win, 2, 2, "File: race_results.rlog | Press 'B' to go back.");
 
     // --- Results Display ---
     wattron(race_win, A_BOLD | COLOR_PAIR(6));
     mvwprintw(race_win, 1, 2, "DATE/TIME                  | WINNER   | DURATION");
     wattroff(race_win, A_BOLD | COLOR_PAIR(6));
 
-    ifstream infile("race_results.txt");
-    string line;
-    vector<string> results;
+    // Served from the in-memory recent-results ring (no file rescans per frame)
     int max_lines = 14;
+    vector<string> results;
+    recentResultLines(max_lines, results);
 
-    // Read all results into a vector
-    while (getline(infile, line)) {
-        results.push_back(line);
+    int line_width = getmaxx(race_win) - 4; // Clip long finish orders at the border
+    for (size_t i = 0; i < results.size(); ++i) {
+        mvwprintw(race_win, 2 + i, 2, "%.*s", line_width, results[i].c_str());
     }
 
-    // Print the last (most recent) results
-    int start_index = results.size() > max_lines ? results.size() - max_lines : 0;
-    int count = 0;
+    if (results.empty()) {
+        mvwprintw(race_win, 2, 2, "No previous race results found. Run a race first!");
+    }
 
-    for (size_t i = start_index; i < results.size(); ++i) {
-        mvwprintw(race_win, 2 + count, 2, "%s", results[i].c_str());
-        count++;
+    // --- Control Window (Back and Exit Buttons) ---
+    string back_text = " B: BACK TO RACE ";
+    string exit_text = " Q: EXIT ";
+
+    int total_width = back_text.length() + exit_text.length() + 3;
+    int start_x = (max_x - total_width) / 2;
+
+    wattron(control_win, COLOR_PAIR(11) | A_BOLD);
+    mvwprintw(control_win, 2, start_x, "%s", back_text.c_str());
+    wattroff(control_win, COLOR_PAIR(11) | A_BOLD);
+
+    wattron(control_win, COLOR_PAIR(10) | A_BOLD);
+    mvwprintw(control_win, 2, start_x + back_text.length() + 3, "%s", exit_text.c_str());
+    wattroff(control_win, COLOR_PAIR(10) | A_BOLD);
+
+    wnoutrefresh(header_win);
+    wnoutrefresh(race_win);
+    wnoutrefresh(control_win);
+    doupdate();
+}
+
+/**
+ * @brief Draws the latency stats screen: one line per histogram, then per-racer counters.
+ */
+void drawStatsGUI(RaceShm* shm) {
+    int max_x = getmaxx(stdscr);
+
+    // This view reuses the track windows; the track view redraws in full when it comes back
+    drawn.valid = false;
+
+    werase(header_win);
+    werase(race_win);
+    werase(control_win);
+    box(race_win, 0, 0);
+
+    wattron(header_win, A_BOLD | COLOR_PAIR(12));
+    mvwprintw(header_win, 1, 2, " CONTROL PATH LATENCY ");
+    wattroff(header_win, A_BOLD | COLOR_PAIR(12));
+    mvwprintw(header_win, 2, 2, "All times in microseconds, since startup | Press 'B' to go back.");
+
+    wattron(race_win, A_BOLD | COLOR_PAIR(6));
+    mvwprintw(race_win, 1, 2, "%-16s %9s %9s %9s %9s %9s %9s", "METRIC", "COUNT", "MEAN", "P50", "P90", "P99", "MAX");
+    wattroff(race_win, A_BOLD | COLOR_PAIR(6));
+
+    RaceStats* stats = raceStats(shm);
+    int y = 2;
+    for (int i = 0; i < HIST_COUNT; ++i, ++y) {
+        const LatencyHistogram* h = &stats->hist[i];
+        uint64_t count = __atomic_load_n(&h->count, __ATOMIC_RELAXED);
+        uint64_t mean = count ? __atomic_load_n(&h->sum_us, __ATOMIC_RELAXED) / count : 0;
+        mvwprintw(race_win, y, 2, "%-16s %9llu %9llu %9llu %9llu %9llu %9llu", HIST_NAMES[i],
+                  (unsigned long long)count, (unsigned long long)mean,
+                  (unsigned long long)histQuantile(h, 0.50), (unsigned long long)histQuantile(h, 0.90),
+                  (unsigned long long)histQuantile(h, 0.99), (unsigned long long)__atomic_load_n(&h->max_us, __ATOMIC_RELAXED));
     }
 
-    if (results.empty()) {
-        mvwprintw(race_win, 2, 2, "No previous race results found. Run a race first!");
+    // Per-racer counters, as many as fit above the border
+    int rows_left = getmaxy(race_win) - y - 3;
+    if (rows_left > 0) {
+        y++;
+        wattron(race_win, A_BOLD | COLOR_PAIR(6));
+        mvwprintw(race_win, y++, 2, "%-16s %9s %12s %16s %10s %5s %6s", "RACER", "STEPS", "PAUSED(ms)", "LAST STEP(ms ago)",
+                  "CPU(ms)", "CPU", "MIGR");
+        wattroff(race_win, A_BOLD | COLOR_PAIR(6));
+
+        static RaceSnapshot snap;
+        takeRaceSnapshot(shm, snap);
+        long now = monotonic_us();
+        for (int i = 0; i < NUM_RACERS && i < rows_left - 1; ++i, ++y) {
+            RacerSlot* slot = racerSlot(shm, i);
+            long last_step_us = snap.racers[i].last_step_us;
+            char age[32] = "-";
+            if (last_step_us != 0) snprintf(age, sizeof(age), "%ld", (now - last_step_us) / 1000);
+            mvwprintw(race_win, y, 2, "Racer %-10d %9d %12ld %16s %10ld %5d %6d", i + 1, snap.racers[i].steps, slot->paused_us / 1000, age,
+                      slot->cpu_us / 1000, slot->cpu, slot->migrations);
+        }
+    }
+
+    // --- Control Window (Back and Exit Buttons) ---
+    string back_text = " B: BACK TO RACE ";
+    string exit_text = " Q: EXIT ";
+
+    int total_width = back_text.length() + exit_text.length() + 3;
+    int start_x = (max_x - total_width) / 2;
+
+    wattron(control_win, COLOR_PAIR(11) | A_BOLD);
+    mvwprintw(control_win, 2, start_x, "%s", back_text.c_str());
+    wattroff(control_win, COLOR_PAIR(11) | A_BOLD);
+
+    wattron(control_win, COLOR_PAIR(10) | A_BOLD);
+    mvwprintw(control_win, 2, start_x + back_text.length() + 3, "%s", exit_text.c_str());
+    wattroff(control_win, COLOR_PAIR(10) | A_BOLD);
+
+    wnoutrefresh(header_win);
+    wnoutrefresh(race_win);
+    wnoutrefresh(control_win);
+    doupdate();
+}
+
+/**
+ * @brief Draws the results analytics screen: winning time statistics and streaks over
+ *        every logged race, then the racers with the most wins.
+ */
+void drawAnalyticsGUI() {
+    int max_x = getmaxx(stdscr);
+
+    // This view reuses the track windows; the track view redraws in full when it comes back
+    drawn.valid = false;
+
+    werase(header_win);
+    werase(race_win);
+    werase(control_win);
+    box(race_win, 0, 0);
+
+    wattron(header_win, A_BOLD | COLOR_PAIR(12));
+    mvwprintw(header_win, 1, 2, " RESULTS ANALYTICS ");
+    wattroff(header_win, A_BOLD | COLOR_PAIR(12));
+    mvwprintw(header_win, 2, 2, "All logged races, from race_results.stats | Press 'B' to go back.");
+
+    // Precomputed aggregates: only refreshed when a result was logged since the last frame
+    static ResultsAnalytics analytics;
+    int rows = getmaxy(race_win) - 2;
+    int racer_rows = rows - 6 > 0 ? rows - 6 : 0;
+    if (!resultsAnalyticsSnapshot(analytics, racer_rows)) {
+        mvwprintw(race_win, 1, 2, "No previous race results found. Run a race first!");
+    } else {
+        wattron(race_win, A_BOLD | COLOR_PAIR(6));
+        mvwprintw(race_win, 1, 2, "RACES: %lld (%lld with a winner)", (long long)analytics.races,
+                  (long long)analytics.timed_races);
+        wattroff(race_win, A_BOLD | COLOR_PAIR(6));
+
+        if (analytics.timed_races > 0) {
+            mvwprintw(race_win, 2, 2, "Winning time: mean %.3fs | sd %.3fs | min %.3fs | max %.3fs",
+                      analytics.mean_ms / 1000.0, analytics.sd_ms / 1000.0, analytics.min_ms / 1000.0,
+                      analytics.max_ms / 1000.0);
+            mvwprintw(race_win, 3, 2, "              p50 %.3fs | p90 %.3fs | p95 %.3fs | p99 %.3fs",
+                      analytics.p50_ms / 1000.0, analytics.p90_ms / 1000.0, analytics.p95_ms / 1000.0,
+                      analytics.p99_ms / 1000.0);
+            mvwprintw(race_win, 4, 2, "Current streak: Racer %d, %lld win(s) | Longest streak: Racer %d, %lld win(s)",
+                      analytics.streak_racer, (long long)analytics.streak, analytics.best_streak_racer,
+                      (long long)analytics.best_streak);
+        }
+
+        if (racer_rows > 0) {
+            wattron(race_win, A_BOLD | COLOR_PAIR(6));
+            mvwprintw(race_win, 6, 2, "%-12s %9s %9s %7s %9s %13s %8s %7s %5s", "RACER", "STARTS", "WINS", "WIN%",
+                      "PODIUMS", "MEAN FINISH", "SD", "STREAK", "BEST");
+            wattroff(race_win, A_BOLD | COLOR_PAIR(6));
+            int y = 7;
+            for (const RacerAnalytics& r : analytics.racers) {
+                if (y > rows) break;
+                mvwprintw(race_win, y++, 2, "Racer %-6d %9lld %9lld %6.1f%% %9lld %12.3fs %7.3fs %7lld %5lld",
+                          r.racer_id, (long long)r.starts, (long long)r.wins,
+                          r.starts ? 100.0 * r.wins / r.starts : 0.0, (long long)r.podiums,
+                          r.finish_mean_ms / 1000.0, r.finish_sd_ms / 1000.0, (long long)r.current_streak,
+                          (long long)r.best_streak);
+            }
+        }
     }
 
     // --- Control Window (Back and Exit Buttons) ---
@@ -294,7 +666,120 @@ void drawResultsGUI() {
     mvwprintw(control_win, 2, start_x + back_text.length() + 3, "%s", exit_text.c_str());
     wattroff(control_win, COLOR_PAIR(10) | A_BOLD);
 
-    wrefresh(header_win);
-    wrefresh(race_win);
-    wrefresh(control_win);
-}
\ No newline at end of file
+    wnoutrefresh(header_win);
+    wnoutrefresh(race_win);
+    wnoutrefresh(control_win);
+    doupdate();
+}
+
+// --- Race Grid ---
+const int GRID_CELL_WIDTH = 25;
+
+/**
+ * @brief Races per grid row, as laid out by drawRaceGridGUI().
+ */
+int raceGridColumns() {
+    int columns = (getmaxx(race_win) - 4) / GRID_CELL_WIDTH;
+    return columns > 0 ? columns : 1;
+}
+
+/**
+ * @brief Draws the --concurrent home view: one cell per race with its status, leader
+ *        and finishers. The selected race is highlighted and kept on screen.
+ */
+void drawRaceGridGUI(RaceShm* arena, int selected, long races_completed) {
+    int max_x = getmaxx(stdscr);
+
+    // This view reuses the track windows; the track view redraws in full when it comes back
+    drawn.valid = false;
+
+    werase(header_win);
+    werase(race_win);
+    werase(control_win);
+    box(race_win, 0, 0);
+
+    int counts[EXITING + 1] = {};
+    for (int race = 0; race < CONCURRENT_RACES; ++race) {
+        int status = getRaceStatus(raceBlock(arena, race));
+        if (status >= 0 && status <= EXITING) counts[status]++;
+    }
+
+    wattron(header_win, A_BOLD | COLOR_PAIR(12));
+    mvwprintw(header_win, 1, 2, " CONCURRENT RACES: %d x %d racers ", CONCURRENT_RACES, NUM_RACERS);
+    wattroff(header_win, A_BOLD | COLOR_PAIR(12));
+    mvwprintw(header_win, 2, 2, "Running: %d | Paused: %d | Finished: %d | Ready: %d | Completed: %ld",
+              counts[RUNNING], counts[PAUSED], counts[FINISHED], counts[READY], races_completed);
+    mvwprintw(header_win, 2, max_x - 30, "PID of Monitor: %d", getpid());
+
+    // Scroll by whole rows so the selected race stays visible
+    int columns = raceGridColumns();
+    int rows = getmaxy(race_win) - 2;
+    int first_row = selected / columns - rows + 1;
+    if (first_row < 0) first_row = 0;
+
+    for (int race = first_row * columns; race < CONCURRENT_RACES; ++race) {
+        int y = 1 + race / columns - first_row;
+        if (y > rows) break;
+        int x = 2 + (race % columns) * GRID_CELL_WIDTH;
+
+        static RaceSnapshot snap;
+        takeRaceSnapshot(raceBlock(arena, race), snap);
+        int status = snap.status;
+        int leader = 0;
+        int finished = 0;
+        for (int i = 0; i < NUM_RACERS; ++i) {
+            int pos = snap.racers[i].position;
+            if (pos >= RACE_LENGTH) finished++;
+            if (pos > snap.racers[leader].position) leader = i;
+        }
+        int lead_pos = snap.racers[leader].position;
+
+        const char* label = "READY";
+        int pair = 13;
+        if (status == RUNNING) {
+            label = "RUN";
+            pair = 8;
+        } else if (status == PAUSED) {
+            label = "PAUSE";
+            pair = 9;
+        } else if (status == FINISHED) {
+            label = "DONE";
+            pair = 5;
+        }
+
+        char cell[64];
+        if (status == READY) {
+            snprintf(cell, sizeof(cell), "#%-3d %-5s", race + 1, label);
+        } else {
+            snprintf(cell, sizeof(cell), "#%-3d %-5s R%-3d %3d%% %d/%d", race + 1, label, leader + 1,
+                     (int)(100L * (lead_pos > RACE_LENGTH ? RACE_LENGTH : lead_pos) / RACE_LENGTH),
+                     finished, NUM_RACERS);
+        }
+
+        int attrs = COLOR_PAIR(pair) | (race == selected ? A_REVERSE | A_BOLD : 0);
+        wattron(race_win, attrs);
+        mvwprintw(race_win, y, x, "%-*.*s", GRID_CELL_WIDTH - 1, GRID_CELL_WIDTH - 1, cell);
+        wattroff(race_win, attrs);
+    }
+
+    // --- Control Window ---
+    string help = "Race " + to_string(selected + 1) + " selected | Arrows: select | Enter/V: view race";
+    mvwprintw(control_win, 1, (max_x - (int)help.length()) / 2, "%s", help.c_str());
+
+    const char* buttons[] = {" S: START ", " P: PAUSE ", " G: START ALL ", " H: PAUSE ALL ", " Q: EXIT "};
+    int pairs[] = {8, 9, 8, 9, 10};
+    int total_width = 4 * 3;
+    for (const char* text : buttons) total_width += strlen(text);
+    int current_x = (max_x - total_width) / 2;
+    for (int i = 0; i < 5; ++i) {
+        wattron(control_win, COLOR_PAIR(pairs[i]) | A_BOLD);
+        mvwprintw(control_win, 3, current_x, "%s", buttons[i]);
+        wattroff(control_win, COLOR_PAIR(pairs[i]) | A_BOLD);
+        current_x += strlen(buttons[i]) + 3;
+    }
+
+    wnoutrefresh(header_win);
+    wnoutrefresh(race_win);
+    wnoutrefresh(control_win);
+    doupdate();
+}
@@ -0,0 +1,604 @@
+#include "RaceLogic.h"
+#include <iostream>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/shm.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <unistd.h>
+#include <vector>
+#include <thread>
+#include <unordered_map>
+#include <signal.h>
+#include <string>
+#include <cerrno>
+
+using namespace std;
+
+// Both backends run the same runRacer() against a RaceShm; they only differ in
+// where the RaceShm lives and how racers are created:
+//   BACKEND_FORK   - SysV segment, one forked process per racer per race, or with
+//                    PREFORK a pool of racer processes forked once at startup
+//   BACKEND_THREAD - in-process arena, a pool of racer threads created once
+// Pooled racers (threads or pre-forked processes) park between races and are
+// re-armed for every race through RaceShm::generation (see runRacerWorker).
+// With --concurrent M every race block of the arena has its own racer set; the
+// functions taking a RaceShm* act on that race only, except the pool start and
+// shutdown, which take the arena and cover every race.
+
+// SysV segment ID (fork backend only, -1 otherwise)
+int race_shmid = -1;
+
+// Length of the mmap'd segment (SHM_POSIX / SHM_MEMFD), rounded up to its page size
+static size_t mapped_bytes = 0;
+static bool mapped_huge = false;
+
+// The monitor's arena (first race block); races are found by their offset from it
+static RaceShm* arena = nullptr;
+
+// The racers of one race
+struct RacerSet {
+    vector<pid_t> children;   // Child PIDs, indexed by racer id - 1; reapRacers() sets reaped entries to 0
+    vector<thread> threads;   // Racer threads (thread backend), parked between races
+};
+static vector<RacerSet> racer_sets; // Indexed by race block
+
+// Race block and racer id of every live child, for reapRacers()
+static unordered_map<pid_t, pair<int, int>> racer_pids;
+
+static RacerSet& racersOf(RaceShm* shm) {
+    return racer_sets[raceBlockIndex(arena, shm)];
+}
+
+static size_t racerCount(const RacerSet& set) {
+    return RACE_BACKEND == BACKEND_THREAD ? set.threads.size() : set.children.size();
+}
+
+static void trackChild(RaceShm* shm, int racer_id, pid_t pid) {
+    racer_pids[pid] = make_pair(raceBlockIndex(arena, shm), racer_id);
+}
+
+/**
+ * @brief True when racers are long-lived workers re-armed per race rather than created per race.
+ */
+static bool pooledRacers() {
+    return RACE_BACKEND == BACKEND_THREAD || PREFORK;
+}
+
+static long futex(int* addr, int op, int val) {
+    return syscall(SYS_futex, addr, op, val, nullptr, nullptr, 0);
+}
+
+// ----------------------------------------------------------------------
+// --- ARENA (WHERE THE RACE STATE LIVES) ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief True when forked racers inherit the monitor's mapping instead of attaching by ID.
+ */
+static bool inheritedSegment() {
+    return RACE_BACKEND == BACKEND_FORK && SHM_KIND != SHM_SYSV;
+}
+
+/**
+ * @brief Maps a SHM_POSIX / SHM_MEMFD segment. The name (POSIX) is unlinked and the
+ *        fd closed before returning, so nothing outlives the processes mapping it.
+ */
+static void* mapSharedSegment(size_t size) {
+    int fd;
+    if (SHM_KIND == SHM_POSIX) {
+        string name = "/process_race." + to_string(getpid());
+        fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd == -1) {
+            perror("shm_open failed");
+            return nullptr;
+        }
+        shm_unlink(name.c_str());
+    } else {
+        fd = -1;
+        if (HUGE_PAGES) {
+            fd = memfd_create("process_race", MFD_CLOEXEC | MFD_HUGETLB);
+            if (fd == -1) {
+                perror("memfd_create (huge pages) failed; using normal pages");
+            }
+        }
+        mapped_huge = fd != -1;
+        if (fd == -1) {
+            fd = memfd_create("process_race", MFD_CLOEXEC);
+        }
+        if (fd == -1) {
+            perror("memfd_create failed");
+            return nullptr;
+        }
+    }
+
+    // Huge page segments must be a multiple of the huge page size (2 MiB on x86-64)
+    size_t page = mapped_huge ? (2UL << 20) : (size_t)sysconf(_SC_PAGESIZE);
+    mapped_bytes = (size + page - 1) / page * page;
+
+    void* addr = MAP_FAILED;
+    if (ftruncate(fd, mapped_bytes) == 0) {
+        addr = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (addr == MAP_FAILED && mapped_huge) {
+        // No reserved huge pages (vm.nr_hugepages): fall back to a normal memfd
+        close(fd);
+        cerr << "Huge pages unavailable (" << strerror(errno) << "); using normal pages.\n";
+        HUGE_PAGES = false;
+        return mapSharedSegment(size);
+    }
+    close(fd);
+    if (addr == MAP_FAILED) {
+        perror("mmap of the race segment failed");
+        return nullptr;
+    }
+    return addr;
+}
+
+/**
+ * @brief Writes the header of every race block and sets up one racer set per race.
+ */
+static RaceShm* initArena(void* addr) {
+    arena = (RaceShm*)addr;
+    for (int i = 0; i < CONCURRENT_RACES; ++i) {
+        initRaceShm(raceBlock(arena, i)); // Versioned header; initial state is READY
+    }
+    racer_sets.clear();
+    racer_sets.resize(CONCURRENT_RACES);
+    return arena;
+}
+
+/**
+ * @brief Creates and initializes the race state for the configured backend: one block
+ *        per concurrent race, in a single segment / allocation.
+ * @return The monitor's mapping (the first race block), or nullptr on failure (error
+ *         already printed).
+ */
+RaceShm* createRaceArena() {
+    if (RACE_BACKEND == BACKEND_THREAD) {
+        RaceShm* shm = (RaceShm*)aligned_alloc(CACHE_LINE_SIZE, SHM_SIZE); // A multiple of the cache line
+        if (shm == nullptr) {
+            perror("aligned_alloc failed");
+            return nullptr;
+        }
+        memset(shm, 0, SHM_SIZE);
+        return initArena(shm);
+    }
+
+    if (SHM_KIND != SHM_SYSV) {
+        void* addr = mapSharedSegment(SHM_SIZE);
+        if (addr == nullptr) return nullptr;
+        return initArena(addr); // Fresh mappings are zero-filled
+    }
+
+    // SHM_SIZE is calculated from NUM_RACERS in RaceConfig.cpp (RaceShm layout)
+    race_shmid = shmget(IPC_PRIVATE, SHM_SIZE, IPC_CREAT | 0666);
+    if (race_shmid == -1) {
+        perror("shmget failed");
+        return nullptr;
+    }
+
+    void* shm_addr = shmat(race_shmid, nullptr, 0);
+    if (shm_addr == (void*)-1) {
+        perror("shmat failed during initialization");
+        cleanup_shm(race_shmid);
+        return nullptr;
+    }
+
+    return initArena(shm_addr);
+}
+
+/**
+ * @brief Releases the race state created by createRaceArena().
+ */
+void destroyRaceArena(RaceShm* shm) {
+    arena = nullptr;
+    racer_sets.clear();
+    if (RACE_BACKEND == BACKEND_THREAD) {
+        free(shm);
+        return;
+    }
+    if (SHM_KIND != SHM_SYSV) {
+        munmap(shm, mapped_bytes);
+        mapped_bytes = 0;
+        return;
+    }
+    detachRaceShm(shm);
+    cleanup_shm(race_shmid);
+    race_shmid = -1;
+}
+
+/**
+ * @brief One-line description of where the race state lives (printed at startup).
+ */
+string describeRaceArena() {
+    string size = to_string(SHM_SIZE) + " bytes";
+    if (RACE_BACKEND == BACKEND_THREAD) {
+        return "Race arena created in-process (" + size;
+    }
+    if (SHM_KIND == SHM_SYSV) {
+        return "Shared Memory segment created with ID: " + to_string(race_shmid) + " (" + size;
+    }
+    return string("Shared memory mapped via ") + (SHM_KIND == SHM_POSIX ? "shm_open" : "memfd") +
+           (mapped_huge ? ", huge pages" : "") + " (" + size + " in " + to_string(mapped_bytes) + " mapped";
+}
+
+// ----------------------------------------------------------------------
+// --- RACER POOL (THREADS OR PRE-FORKED PROCESSES) ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief The race block as seen by a freshly forked racer: its block of a SysV attach
+ *        by ID, or the mapping inherited from the monitor (no syscall at all).
+ */
+static RaceShm* attachChildShm(RaceShm* inherited) {
+    if (inheritedSegment()) return inherited;
+    RaceShm* base = attachRaceShm(race_shmid);
+    return base == nullptr ? nullptr : raceBlock(base, raceBlockIndex(arena, inherited));
+}
+
+static void detachChildShm(RaceShm* child_shm, RaceShm* inherited) {
+    if (inheritedSegment()) return;
+    size_t offset = reinterpret_cast<char*>(inherited) - reinterpret_cast<char*>(arena);
+    detachRaceShm(reinterpret_cast<RaceShm*>(reinterpret_cast<char*>(child_shm) - offset));
+}
+
+/**
+ * @brief Takes a pooled racer out of the current race; the last one out wakes the
+ *        monitor waiting in waitForIdleWorkers(). Called by the racer itself or, if it
+ *        died, by reapRacers() - the exchange makes sure it is counted only once.
+ */
+static void leaveRace(RaceShm* shm, RacerSlot* slot) {
+    if (__atomic_exchange_n(&slot->worker_active, 0, __ATOMIC_ACQ_REL) == 0) return;
+    if (__atomic_sub_fetch(&shm->active_workers, 1, __ATOMIC_ACQ_REL) == 0) {
+        futex(&shm->active_workers, FUTEX_WAKE, INT_MAX);
+    }
+}
+
+/**
+ * @brief Body of a pooled racer: parks on RaceShm::generation, runs one race per
+ *        generation bump and exits once the status is EXITING. `seen_generation` is
+ *        the last generation already handed out when the worker was created.
+ */
+void runRacerWorker(int racer_id, RaceShm* shm, int seen_generation) {
+    RacerSlot* slot = racerSlot(shm, racer_id - 1);
+    applyRacerScheduling(shm, racer_id);
+    while (true) {
+        int generation = __atomic_load_n(&shm->generation, __ATOMIC_ACQUIRE);
+        if (generation == seen_generation) {
+            futex(&shm->generation, FUTEX_WAIT, generation);
+            continue;
+        }
+        seen_generation = generation;
+
+        if (getRaceStatus(shm) == EXITING) {
+            return;
+        }
+
+        runRacer(racer_id, shm);
+        slot->races_served++;
+        leaveRace(shm, slot);
+    }
+}
+
+/**
+ * @brief Blocks until every pooled racer has left the current race. Pre-forked racers
+ *        can die while we wait, so the wait is sliced and dead ones are reaped in between.
+ */
+static void waitForIdleWorkers(RaceShm* shm) {
+    struct timespec slice = {0, 100 * 1000000L};
+    int active;
+    while ((active = __atomic_load_n(&shm->active_workers, __ATOMIC_ACQUIRE)) != 0) {
+        if (RACE_BACKEND == BACKEND_THREAD) {
+            futex(&shm->active_workers, FUTEX_WAIT, active);
+        } else {
+            syscall(SYS_futex, &shm->active_workers, FUTEX_WAIT, active, &slice, nullptr, 0);
+            reapRacers();
+        }
+    }
+}
+
+/**
+ * @brief Forks one pooled racer that serves races until EXITING. `generation` is the
+ *        monitor's current one, so a respawned racer waits for the next arm.
+ * @return The child's pid, or -1 if fork() failed.
+ */
+static pid_t forkPoolWorker(int racer_id, RaceShm* shm) {
+    int generation = __atomic_load_n(&shm->generation, __ATOMIC_ACQUIRE);
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Pooled child: attach once (or use the inherited mapping), then serve races until EXITING
+        prepareRacerChild();
+        RaceShm* child_shm = attachChildShm(shm);
+        if (child_shm == nullptr) {
+            perror("Racer shmat failed");
+            _exit(EXIT_FAILURE);
+        }
+        runRacerWorker(racer_id, child_shm, generation);
+        detachChildShm(child_shm, shm);
+        _exit(EXIT_SUCCESS); // Not exit(): that would flush the monitor's inherited output buffers again
+    }
+    return pid;
+}
+
+/**
+ * @brief Starts the pooled racers once at startup: NUM_RACERS threads, or NUM_RACERS
+ *        pre-forked processes that attach the segment once and stay attached, for every
+ *        race of the arena. Does nothing for the per-race fork backend.
+ */
+bool startRacerPool(RaceShm* shm) {
+    if (!pooledRacers()) return true;
+
+    cout.flush();
+    fflush(stdout);
+    for (int race = 0; race < CONCURRENT_RACES; ++race) {
+        RaceShm* race_shm = raceBlock(shm, race);
+        RacerSet& set = racer_sets[race];
+        for (int i = 1; i <= NUM_RACERS; ++i) {
+            if (RACE_BACKEND == BACKEND_THREAD) {
+                set.threads.emplace_back(runRacerWorker, i, race_shm, 0);
+                continue;
+            }
+            pid_t pid = forkPoolWorker(i, race_shm);
+            if (pid == -1) {
+                perror("fork failed");
+                cerr << "Could only pre-fork " << (race * NUM_RACERS + i - 1) << " of "
+                     << CONCURRENT_RACES * NUM_RACERS << " racers.\n";
+                return false;
+            }
+            set.children.push_back(pid);
+            trackChild(race_shm, i, pid);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Replaces pre-forked racers that died since the previous race, so a crash
+ *        costs one DNF rather than a permanently smaller field.
+ */
+static void respawnDeadWorkers(RaceShm* shm) {
+    if (RACE_BACKEND == BACKEND_THREAD) return;
+
+    cout.flush();
+    fflush(stdout);
+    vector<pid_t>& children = racersOf(shm).children;
+    for (int i = 1; i <= (int)children.size(); ++i) {
+        if (children[i - 1] != 0) continue;
+        pid_t pid = forkPoolWorker(i, shm);
+        if (pid == -1) {
+            perror("fork failed (respawning racer)");
+            continue; // Stays dead: armWorkers() marks it DNF for this race
+        }
+        children[i - 1] = pid;
+        trackChild(shm, i, pid);
+    }
+}
+
+/**
+ * @brief Moves all live pooled racers to the next race generation. Racers whose
+ *        process is gone are not waited for and start the race as DNF.
+ */
+static void armWorkers(RaceShm* shm) {
+    const vector<pid_t>& children = racersOf(shm).children;
+    int live = 0;
+    for (int i = 0; i < NUM_RACERS; ++i) {
+        bool alive = RACE_BACKEND == BACKEND_THREAD || children[i] != 0;
+        __atomic_store_n(&racerSlot(shm, i)->worker_active, alive ? 1 : 0, __ATOMIC_RELAXED);
+        if (alive) {
+            live++;
+        } else if (getRaceStatus(shm) != EXITING) {
+            markRacerDnf(shm, i + 1);
+        }
+    }
+    __atomic_store_n(&shm->active_workers, live, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&shm->generation, 1, __ATOMIC_ACQ_REL);
+    futex(&shm->generation, FUTEX_WAKE, INT_MAX);
+}
+
+/**
+ * @brief Reaps every racer process that has exited, in any race (monitor side, on
+ *        SIGCHLD). A racer that died before crossing the line of a live race is marked
+ *        DNF, and a dead pooled racer is taken out of the race so nobody waits for it.
+ */
+void reapRacers() {
+    int wait_status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &wait_status, WNOHANG)) > 0) {
+        auto owner = racer_pids.find(pid);
+        if (owner == racer_pids.end() || arena == nullptr) continue;
+        int race = owner->second.first;
+        int racer_id = owner->second.second;
+        racer_pids.erase(owner);
+        racer_sets[race].children[racer_id - 1] = 0;
+
+        RaceShm* shm = raceBlock(arena, race);
+        RacerSlot* slot = racerSlot(shm, racer_id - 1);
+        bool crashed = !WIFEXITED(wait_status) || WEXITSTATUS(wait_status) != EXIT_SUCCESS;
+        int status = getRaceStatus(shm);
+        bool racing = status == READY || status == RUNNING || status == PAUSED;
+        if (crashed && racing && __atomic_load_n(&slot->finish_time_ms, __ATOMIC_ACQUIRE) == 0) {
+            markRacerDnf(shm, racer_id);
+        }
+        if (pooledRacers()) {
+            leaveRace(shm, slot);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------
+// --- RACE START / TEARDOWN ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief Stops the racers of the previous race.
+ *        Fork backend: kills and reaps the child processes.
+ *        Pooled racers: ends the race if it is still running and waits for every
+ *        racer to park again (they are only stopped by shutdownRacers()).
+ */
+void cleanup_children(RaceShm* shm) {
+    RacerSet& set = racersOf(shm);
+    if (pooledRacers()) {
+        if (racerCount(set) == 0) return;
+        int status = getRaceStatus(shm);
+        if (status != FINISHED && status != EXITING) {
+            setRaceStatus(shm, FINISHED);
+        }
+        waitForIdleWorkers(shm);
+        return;
+    }
+
+    if (set.children.empty()) return;
+
+    for (pid_t child_pid : set.children) {
+        if (child_pid == 0) continue; // Already reaped by reapRacers()
+        racer_pids.erase(child_pid);
+        int status;
+        // Check if the child is still running (waitpid with WNOHANG)
+        if (waitpid(child_pid, &status, WNOHANG) == 0) {
+            // If running, kill it forcefully
+            if (kill(child_pid, SIGKILL) == 0) {
+                // Wait for the killed process to be reaped
+                waitpid(child_pid, &status, 0);
+            } else {
+                perror("kill failed");
+            }
+        }
+    }
+    set.children.clear();
+}
+
+/**
+ * @brief Starts the racers for a new race. (Called by RaceLogic.cpp when 'S' is pressed)
+ *        The status is left at READY; the caller sets RUNNING.
+ */
+void start_race_processes(RaceShm* shm) {
+    // 1. Cleanup any previous racers first (if the user restarted before cleanup)
+    cleanup_children(shm);
+    drainRaceTrace(shm); // The previous race's last steps, before the reset
+
+    // 2. Re-initialize shared memory positions/PIDs before starting racers
+    resetRaceState(shm);
+    setRaceStatus(shm, READY);
+
+    if (pooledRacers()) {
+        // 3. The pool is already running: a single wakeup starts the race
+        respawnDeadWorkers(shm);
+        armWorkers(shm);
+        return;
+    }
+
+    // 3. Fork new children (flush first so buffered output is not duplicated by each child's exit)
+    cout.flush();
+    fflush(stdout);
+    for (int i = 1; i <= NUM_RACERS; ++i) {
+        pid_t pid = fork();
+
+        if (pid == -1) {
+            perror("fork failed");
+            cerr << "Could only start " << (i - 1) << " of " << NUM_RACERS << " racers.\n";
+            cleanup_children(shm);
+            destroyRaceArena(arena);
+            exit(1);
+        }
+
+        if (pid == 0) {
+            // Child Process attaches the SysV segment itself (POSIX/memfd mappings are
+            // inherited) and runs racer logic
+            prepareRacerChild();
+            RaceShm* child_shm = attachChildShm(shm);
+            if (child_shm == nullptr) {
+                perror("Racer shmat failed");
+                _exit(EXIT_FAILURE);
+            }
+            applyRacerScheduling(child_shm, i);
+            runRacer(i, child_shm);
+            detachChildShm(child_shm, shm);
+            _exit(EXIT_SUCCESS); // See forkPoolWorker()
+        } else {
+            // Parent Process stores child PID
+            racersOf(shm).children.push_back(pid);
+            trackChild(shm, i, pid);
+        }
+    }
+}
+
+/**
+ * @brief Final teardown at exit: stops every race of the arena and joins/reaps the
+ *        racers. Races not yet EXITING are set to EXITING first.
+ */
+void shutdownRacers(RaceShm* shm) {
+    for (int race = 0; race < (int)racer_sets.size(); ++race) {
+        RaceShm* race_shm = raceBlock(shm, race);
+        if (getRaceStatus(race_shm) != EXITING) setRaceStatus(race_shm, EXITING);
+    }
+
+    for (int race = 0; race < (int)racer_sets.size(); ++race) {
+        RaceShm* race_shm = raceBlock(shm, race);
+        RacerSet& set = racer_sets[race];
+        if (!pooledRacers()) {
+            cleanup_children(race_shm);
+            continue;
+        }
+        if (racerCount(set) == 0) continue;
+
+        waitForIdleWorkers(race_shm);
+        // Wake the parked pool once more; it sees EXITING and returns
+        armWorkers(race_shm);
+        for (thread& t : set.threads) {
+            t.join();
+        }
+        set.threads.clear();
+        for (pid_t child_pid : set.children) {
+            if (child_pid == 0) continue;
+            waitpid(child_pid, nullptr, 0);
+            racer_pids.erase(child_pid);
+        }
+        set.children.clear();
+    }
+}
+
+/**
+ * @brief Prints how many races each pooled racer served (summary for large pools).
+ */
+void printRacerPoolReport(RaceShm* shm) {
+    if (!pooledRacers()) return;
+
+    long total = 0;
+    int min_served = INT_MAX, max_served = 0;
+    for (int race = 0; race < CONCURRENT_RACES; ++race) {
+        for (int i = 0; i < NUM_RACERS; ++i) {
+            int served = racerSlot(raceBlock(shm, race), i)->races_served;
+            total += served;
+            if (served < min_served) min_served = served;
+            if (served > max_served) max_served = served;
+        }
+    }
+
+    cout << "Racer pool (" << (RACE_BACKEND == BACKEND_THREAD ? "threads" : "pre-forked processes")
+         << "): " << total << " racer-races served";
+    if (CONCURRENT_RACES == 1 && NUM_RACERS <= 16) {
+        cout << " |";
+        for (int i = 0; i < NUM_RACERS; ++i) {
+            cout << " R" << (i + 1) << "=" << racerSlot(shm, i)->races_served;
+        }
+    } else {
+        cout << " | per worker min " << min_served << ", max " << max_served;
+    }
+    cout << "\n";
+}
+
+/**
+ * @brief Number of racers currently started in all races (child processes or pool threads).
+ */
+size_t activeRacerCount() {
+    size_t count = 0;
+    for (const RacerSet& set : racer_sets) count += racerCount(set);
+    return count;
+}
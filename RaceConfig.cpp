@@ -0,0 +1,405 @@
+#include "RaceLogic.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstdlib>
+#include <climits>
+#include <cerrno>
+#include <unistd.h>
+
+using namespace std;
+
+// --- CONFIGURATION (DEFINITIONS) ---
+// Defaults match the original fixed 4-racer / 100-unit race. Both values can be
+// overridden at startup by configureRace() before the shared memory is created.
+int RACE_LENGTH = 100;
+int NUM_RACERS = 4;
+int SYNC_MODE = SYNC_EVENT;
+int MAX_FPS = 60;
+int PODIUM_SIZE = 1;
+int CONCURRENT_RACES = 1;
+int TOURNAMENT_ENTRANTS = 0;
+bool HEADLESS = false;
+int HEADLESS_RACES = 1;
+double DELAY_SCALE = 1.0;
+bool LOG_RESULTS = true;
+int RACE_BACKEND = BACKEND_FORK;
+bool PREFORK = false;
+int SHM_KIND = SHM_SYSV;
+bool HUGE_PAGES = false;
+int RESULTS_TAIL = 0;
+bool RESULTS_ANALYTICS = false;
+int SIMULATE_RACES = 0;
+string STATS_OUT;
+string STATS_SOCKET;
+string RECORD_PATH;
+string REPLAY_PATH;
+double REPLAY_SPEED = 1.0;
+uint64_t RACE_SEED = 0;
+bool RACE_SEED_SET = false;
+
+// --- Shared Memory Size (Definition) ---
+// Computed by computeShmLayout() once NUM_RACERS and CONCURRENT_RACES are known.
+size_t RACE_BLOCK_SIZE = 0;
+size_t SHM_SIZE = 0;
+
+static bool concurrent_set = false; // --concurrent given (a tournament defaults it otherwise)
+
+// ----------------------------------------------------------------------
+// --- HELPERS ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief Parses a bounded integer option value. Returns false on bad input.
+ */
+static bool parseIntOption(const string& name, const string& value, int min_value, int max_value, int& out) {
+    char* end = nullptr;
+    long parsed = strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || parsed < min_value || parsed > max_value) {
+        cerr << "Error: " << name << " must be an integer in [" << min_value << ", " << max_value
+             << "], got '" << value << "'." << endl;
+        return false;
+    }
+    out = (int)parsed;
+    return true;
+}
+
+/**
+ * @brief Parses a non-negative floating point option value. Returns false on bad input.
+ */
+static bool parseScaleOption(const string& name, const string& value, double& out) {
+    char* end = nullptr;
+    double parsed = strtod(value.c_str(), &end);
+    if (value.empty() || *end != '\0' || parsed < 0.0 || parsed > 1000.0) {
+        cerr << "Error: " << name << " must be a number in [0, 1000], got '" << value << "'." << endl;
+        return false;
+    }
+    out = parsed;
+    return true;
+}
+
+/**
+ * @brief Parses a boolean option value (true/false, yes/no, on/off, 1/0).
+ */
+static bool parseBoolOption(const string& name, const string& value, bool& out) {
+    if (value == "true" || value == "yes" || value == "on" || value == "1") {
+        out = true;
+    } else if (value == "false" || value == "no" || value == "off" || value == "0") {
+        out = false;
+    } else {
+        cerr << "Error: " << name << " must be true or false, got '" << value << "'." << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses a 64-bit seed (decimal or 0x-prefixed hex).
+ */
+static bool parseSeedOption(const string& name, const string& value, uint64_t& out) {
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long parsed = strtoull(value.c_str(), &end, 0);
+    if (value.empty() || value[0] == '-' || *end != '\0' || errno == ERANGE) {
+        cerr << "Error: " << name << " must be an unsigned 64-bit integer, got '" << value << "'." << endl;
+        return false;
+    }
+    out = (uint64_t)parsed;
+    return true;
+}
+
+static string trim(const string& s) {
+    size_t begin = s.find_first_not_of(" \t\r\n");
+    if (begin == string::npos) return "";
+    size_t end = s.find_last_not_of(" \t\r\n");
+    return s.substr(begin, end - begin + 1);
+}
+
+/**
+ * @brief Applies a single "key = value" setting (shared by the CLI and the config file).
+ */
+static bool applySetting(const string& key, const string& value) {
+    if (key == "racers") {
+        return parseIntOption("racers", value, 1, MAX_RACERS, NUM_RACERS);
+    } else if (key == "length") {
+        return parseIntOption("length", value, 1, MAX_RACE_LENGTH, RACE_LENGTH);
+    } else if (key == "podium") {
+        return parseIntOption("podium", value, 0, MAX_RACERS, PODIUM_SIZE);
+    } else if (key == "concurrent") {
+        concurrent_set = true;
+        return parseIntOption("concurrent", value, 1, MAX_CONCURRENT_RACES, CONCURRENT_RACES);
+    } else if (key == "tournament") {
+        return parseIntOption("tournament", value, 2, MAX_TOURNAMENT_ENTRANTS, TOURNAMENT_ENTRANTS);
+    } else if (key == "max-fps") {
+        return parseIntOption("max-fps", value, 1, MAX_MAX_FPS, MAX_FPS);
+    } else if (key == "headless") {
+        return parseBoolOption("headless", value, HEADLESS);
+    } else if (key == "races") {
+        return parseIntOption("races", value, 1, INT_MAX, HEADLESS_RACES);
+    } else if (key == "delay-scale") {
+        return parseScaleOption("delay-scale", value, DELAY_SCALE);
+    } else if (key == "log") {
+        return parseBoolOption("log", value, LOG_RESULTS);
+    } else if (key == "backend") {
+        if (value == "fork") RACE_BACKEND = BACKEND_FORK;
+        else if (value == "thread") RACE_BACKEND = BACKEND_THREAD;
+        else {
+            cerr << "Error: backend must be 'fork' or 'thread', got '" << value << "'." << endl;
+            return false;
+        }
+        return true;
+    } else if (key == "shm") {
+        if (value == "sysv") SHM_KIND = SHM_SYSV;
+        else if (value == "posix") SHM_KIND = SHM_POSIX;
+        else if (value == "memfd") SHM_KIND = SHM_MEMFD;
+        else {
+            cerr << "Error: shm must be 'sysv', 'posix' or 'memfd', got '" << value << "'." << endl;
+            return false;
+        }
+        return true;
+    } else if (key == "hugepages") {
+        return parseBoolOption("hugepages", value, HUGE_PAGES);
+    } else if (key == "prefork") {
+        return parseBoolOption("prefork", value, PREFORK);
+    } else if (key == "results-tail") {
+        return parseIntOption("results-tail", value, 1, INT_MAX, RESULTS_TAIL);
+    } else if (key == "analytics") {
+        return parseBoolOption("analytics", value, RESULTS_ANALYTICS);
+    } else if (key == "stats-out") {
+        STATS_OUT = value;
+        return true;
+    } else if (key == "stats-socket") {
+        STATS_SOCKET = value;
+        return true;
+    } else if (key == "simulate") {
+        return parseIntOption("simulate", value, 1, INT_MAX, SIMULATE_RACES);
+    } else if (key == "record") {
+        RECORD_PATH = value;
+        return true;
+    } else if (key == "replay") {
+        REPLAY_PATH = value;
+        return true;
+    } else if (key == "speed") {
+        if (!parseScaleOption("speed", value, REPLAY_SPEED)) return false;
+        if (REPLAY_SPEED <= 0.0) {
+            cerr << "Error: speed must be greater than 0." << endl;
+            return false;
+        }
+        return true;
+    } else if (key == "seed") {
+        RACE_SEED_SET = parseSeedOption("seed", value, RACE_SEED);
+        return RACE_SEED_SET;
+    } else if (key == "profile" || key.rfind("profile.", 0) == 0 ||
+               (key.rfind("racer.", 0) == 0 && key.size() > 8 && key.compare(key.size() - 8, 8, ".profile") == 0)) {
+        return applyProfileSetting(key, value);
+    } else if (key.rfind("racer.", 0) == 0 || key == "cpus" || key == "nice" || key == "policy" ||
+               key == "pin" || key == "step-mode") {
+        return applySchedulingSetting(key, value);
+    } else if (key == "sync") {
+        if (value == "event") SYNC_MODE = SYNC_EVENT;
+        else if (value == "poll") SYNC_MODE = SYNC_POLL;
+        else {
+            cerr << "Error: sync must be 'event' or 'poll', got '" << value << "'." << endl;
+            return false;
+        }
+        return true;
+    }
+    cerr << "Error: Unknown setting '" << key << "'." << endl;
+    return false;
+}
+
+/**
+ * @brief Loads "key = value" lines from a config file. '#' starts a comment.
+ */
+static bool loadConfigFile(const string& path) {
+    ifstream infile(path);
+    if (!infile.is_open()) {
+        cerr << "Error: Could not open config file '" << path << "'." << endl;
+        return false;
+    }
+
+    string line;
+    int line_no = 0;
+    while (getline(infile, line)) {
+        line_no++;
+        size_t hash = line.find('#');
+        if (hash != string::npos) line = line.substr(0, hash);
+        line = trim(line);
+        if (line.empty()) continue;
+
+        size_t eq = line.find('=');
+        if (eq == string::npos) {
+            cerr << "Error: " << path << ":" << line_no << ": expected 'key = value'." << endl;
+            return false;
+        }
+        if (!applySetting(trim(line.substr(0, eq)), trim(line.substr(eq + 1)))) {
+            cerr << "  (in " << path << ":" << line_no << ")" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void printUsage(const char* prog) {
+    cout << "Usage: " << prog << " [options]\n"
+         << "  -n, --racers N        Number of racer processes (1-" << MAX_RACERS << ", default 4)\n"
+         << "  -l, --length N        Race length in steps (1-" << MAX_RACE_LENGTH << ", default 100)\n"
+         << "      --podium N        Finishers that end the race (default 1, 0 = all racers)\n"
+         << "      --concurrent M    Run M independent races at once under one monitor (default 1)\n"
+         << "      --sync MODE       'event' (futex/eventfd wakeups, default) or 'poll' (usleep loops)\n"
+         << "      --max-fps N       Redraw at most N times per second, only when something changed (default 60)\n"
+         << "      --backend KIND    'fork' (process per racer, default) or 'thread' (racer thread pool)\n"
+         << "      --prefork         Fork backend: fork the racers once and re-arm them for each race\n"
+         << "      --shm KIND        Fork backend segment: 'sysv' (default), 'posix' (shm_open) or 'memfd'\n"
+         << "      --hugepages       With --shm memfd: use huge pages when the system has them reserved\n"
+         << "      --step-mode MODE  'sleep' (default) or 'work': burn each step's delay as CPU time\n"
+         << "      --pin MODE        'none' (default) or 'spread': pin racer i to the i-th allowed CPU\n"
+         << "      --cpus LIST       CPU list for every racer, e.g. '0-3,8' (racer.N.cpus for one racer)\n"
+         << "      --nice N          Nice value for every racer (racer.N.nice; below 0 needs privileges)\n"
+         << "      --policy P        other, batch, idle, fifo or rr (racer.N.policy, racer.N.priority)\n"
+         << "      --profile NAME    Step/delay profile for every racer (profile.NAME.*, racer.N.profile)\n"
+         << "      --headless        Run races back-to-back without the TUI and print throughput\n"
+         << "      --races N         Number of races in a headless run (default 1, spread over --concurrent)\n"
+         << "      --tournament N    Elimination tournament of N entrants in heats of --racers, without the\n"
+         << "                        TUI; the first --podium of each heat advance, --concurrent heats at a\n"
+         << "                        time (default: one per CPU)\n"
+         << "      --delay-scale X   Multiply the per-step delay by X (0 = no sleeps, default 1)\n"
+         << "      --stats-out FILE  Write latency histograms and racer counters as JSON on exit\n"
+         << "      --stats-socket P  Stream live snapshots and results as JSON lines on Unix socket P\n"
+         << "      --simulate N      Simulate N races in-process (no processes or sleeps), print win odds\n"
+         << "      --record FILE     Record every racer step to FILE (compact trace, see --replay)\n"
+         << "      --replay FILE     Replay a recorded trace in the TUI (--headless: print a summary)\n"
+         << "      --speed X         Replay speed (default 1 = real time, 4 = four times faster)\n"
+         << "      --seed N          Seed of the first race (replays a logged race; default random)\n"
+         << "      --no-log          Do not write race_results.txt, race_results.rlog or race_results.stats\n"
+         << "      --results-tail N  Print the last N results from race_results.rlog and exit\n"
+         << "      --analytics       Print win rates, winning time quantiles and streaks over all results and exit\n"
+         << "  -c, --config FILE     Load settings from FILE ('racers = N', 'sync = poll', ...)\n"
+         << "  -h, --help            Show this help\n"
+         << "Command line options override values from the config file.\n";
+}
+
+// ----------------------------------------------------------------------
+// --- LAYOUT AND STARTUP CONFIGURATION ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief Derives RACE_BLOCK_SIZE and SHM_SIZE from NUM_RACERS and CONCURRENT_RACES
+ *        (see the RaceShm layout in RaceLogic.h).
+ */
+void computeShmLayout() {
+    size_t block = raceShmSize(NUM_RACERS, RECORD_PATH.empty() ? 0 : TRACE_RING_SIZE);
+    RACE_BLOCK_SIZE = (block + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    SHM_SIZE = RACE_BLOCK_SIZE * CONCURRENT_RACES;
+}
+
+/**
+ * @brief Reads racer count and race length from the command line and/or a config file.
+ * @return CONFIG_RUN to go on, CONFIG_EXIT after --help, CONFIG_ERROR after a bad option.
+ */
+ConfigResult configureRace(int argc, char* argv[]) {
+    // The config file is applied first so that explicit CLI options win.
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if ((arg == "-c" || arg == "--config") && i + 1 < argc) {
+            if (!loadConfigFile(argv[++i])) return CONFIG_ERROR;
+        }
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            printUsage(argv[0]);
+            return CONFIG_EXIT;
+        }
+
+        // Short aliases map onto the long setting names
+        if (arg == "-n") arg = "--racers";
+        else if (arg == "-l") arg = "--length";
+        else if (arg == "-c") arg = "--config";
+
+        // Flags without a value
+        if (arg == "--headless") {
+            HEADLESS = true;
+            continue;
+        } else if (arg == "--prefork") {
+            PREFORK = true;
+            continue;
+        } else if (arg == "--hugepages") {
+            HUGE_PAGES = true;
+            continue;
+        } else if (arg == "--no-log") {
+            LOG_RESULTS = false;
+            continue;
+        } else if (arg == "--analytics") {
+            RESULTS_ANALYTICS = true;
+            continue;
+        }
+
+        if (arg.rfind("--", 0) != 0) {
+            cerr << "Error: Unexpected argument '" << arg << "'." << endl;
+            printUsage(argv[0]);
+            return CONFIG_ERROR;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Error: " << arg << " requires a value." << endl;
+            return CONFIG_ERROR;
+        }
+
+        string key = arg.substr(2);
+        string value = argv[++i];
+        if (key == "config") continue; // Already loaded above
+        if (!applySetting(key, value)) {
+            printUsage(argv[0]);
+            return CONFIG_ERROR;
+        }
+    }
+
+    if (HUGE_PAGES && SHM_KIND != SHM_MEMFD) {
+        cerr << "Error: --hugepages requires --shm memfd." << endl;
+        return CONFIG_ERROR;
+    }
+
+    if (TOURNAMENT_ENTRANTS > 0) {
+        if (NUM_RACERS < 2 || PODIUM_SIZE < 1 || PODIUM_SIZE >= NUM_RACERS) {
+            cerr << "Error: --tournament needs at least 2 racers per heat and --podium (the finishers "
+                    "that advance from each heat) between 1 and racers - 1." << endl;
+            return CONFIG_ERROR;
+        }
+        if (!REPLAY_PATH.empty() || SIMULATE_RACES > 0) {
+            cerr << "Error: --tournament cannot be combined with --replay or --simulate." << endl;
+            return CONFIG_ERROR;
+        }
+        HEADLESS = true;
+        if (!concurrent_set && RECORD_PATH.empty()) {
+            // One heat per CPU, but no more lanes than the first round has heats
+            long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+            long heats = (TOURNAMENT_ENTRANTS + NUM_RACERS - 1) / NUM_RACERS;
+            long lanes = cpus < heats ? cpus : heats;
+            CONCURRENT_RACES = (int)(lanes < 1 ? 1 : (lanes > MAX_CONCURRENT_RACES ? MAX_CONCURRENT_RACES : lanes));
+        }
+    }
+
+    if (!RECORD_PATH.empty() && !REPLAY_PATH.empty()) {
+        cerr << "Error: --record and --replay cannot be combined." << endl;
+        return CONFIG_ERROR;
+    }
+    if (!STATS_SOCKET.empty() && (!REPLAY_PATH.empty() || SIMULATE_RACES > 0)) {
+        cerr << "Error: --stats-socket needs live races (not --replay or --simulate)." << endl;
+        return CONFIG_ERROR;
+    }
+    if (CONCURRENT_RACES > 1 && (!RECORD_PATH.empty() || !REPLAY_PATH.empty())) {
+        cerr << "Error: --record and --replay need a single race (not --concurrent)." << endl;
+        return CONFIG_ERROR;
+    }
+
+    if (!finishSchedulingConfig()) {
+        return CONFIG_ERROR;
+    }
+    if (!finishProfileConfig()) {
+        return CONFIG_ERROR;
+    }
+
+    computeShmLayout();
+    return CONFIG_RUN;
+}
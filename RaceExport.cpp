@@ -0,0 +1,361 @@
+#include "RaceLogic.h"
+#include <iostream>
+#include <map>
+#include <string>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+using namespace std;
+
+// ----------------------------------------------------------------------
+// --- LIVE STATS EXPORT (--stats-socket PATH) ---
+// ----------------------------------------------------------------------
+
+// The monitor listens on a Unix stream socket and streams newline-delimited JSON
+// to every subscriber:
+//   {"type": "hello", ...}     once, on connect: run parameters
+//   {"type": "snapshot", ...}  per race, when racers moved (at most MAX_FPS a second)
+//                              and once on connect; taken with takeRaceSnapshot()
+//   {"type": "result", ...}    every result, as it is logged
+//   {"type": "exit"}           when the monitor shuts down
+// All sockets are non-blocking and sit in one epoll set, whose fd the monitor polls
+// next to stdin and the racer eventfd. The monitor never waits for a subscriber:
+// a snapshot is formatted once and queued for every client, a client that still has
+// output queued skips it (and gets the next one), and a client whose live updates
+// queue up past EXPORT_MAX_BACKLOG (results it does not read) is disconnected. The
+// snapshot sent on connect, one line per race, is not charged to that limit: on a
+// large arena it alone can exceed it.
+
+int stats_export_fd = -1;
+
+const int EXPORT_MAX_CLIENTS = 256;
+const size_t EXPORT_MAX_BACKLOG = 4 << 20; // Queued bytes per client
+const int EXPORT_EVENTS = 64;              // epoll_wait batch
+
+static const char* const STATUS_NAMES[] = {"ready", "running", "paused", "finished", "exiting"};
+
+struct ExportClient {
+    string out;          // Queued lines; out[sent..] is still to be written
+    size_t sent = 0;
+    bool want_out = false; // EPOLLOUT is armed
+    uint64_t written = 0;        // Bytes written over the connection
+    uint64_t initial_bytes = 0;  // Bytes queued on connect (hello and first snapshots)
+};
+
+static int listen_fd = -1;
+static string socket_path;
+static map<int, ExportClient> clients;
+
+/**
+ * @brief Creates the listening socket at `path` (replacing a socket left by a dead
+ *        monitor, never any other kind of file) and the epoll set.
+ */
+bool openStatsExport(const string& path) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        cerr << "Error: --stats-socket path is longer than " << sizeof(addr.sun_path) - 1 << " bytes." << endl;
+        return false;
+    }
+    memcpy(addr.sun_path, path.c_str(), path.size());
+
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            cerr << "Error: '" << path << "' exists and is not a socket." << endl;
+            return false;
+        }
+        // A live monitor still accepts on it; a dead one left it behind
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        bool in_use = probe != -1 && connect(probe, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+        if (probe != -1) close(probe);
+        if (in_use) {
+            cerr << "Error: '" << path << "' is in use by another monitor." << endl;
+            return false;
+        }
+        unlink(path.c_str());
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd == -1) {
+        perror("socket failed");
+        return false;
+    }
+    if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) == -1 || listen(listen_fd, 64) == -1) {
+        cerr << "Error: Could not listen on '" << path << "': " << strerror(errno) << endl;
+        close(listen_fd);
+        listen_fd = -1;
+        return false;
+    }
+    socket_path = path;
+
+    stats_export_fd = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = listen_fd;
+    if (stats_export_fd == -1 || epoll_ctl(stats_export_fd, EPOLL_CTL_ADD, listen_fd, &ev) == -1) {
+        perror("epoll failed");
+        closeStatsExport();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Closes every export fd without unlinking the socket: run in forked racers,
+ *        so a subscriber the monitor drops is not kept connected by a racer's copy.
+ */
+void dropStatsExport() {
+    for (auto& entry : clients) {
+        close(entry.first);
+    }
+    clients.clear();
+    if (listen_fd != -1) {
+        close(listen_fd);
+        listen_fd = -1;
+    }
+    if (stats_export_fd != -1) {
+        close(stats_export_fd);
+        stats_export_fd = -1;
+    }
+}
+
+static void dropClient(int fd) {
+    close(fd); // Also leaves the epoll set
+    clients.erase(fd);
+}
+
+/**
+ * @brief Writes as much of the client's queue as the socket takes and arms EPOLLOUT
+ *        for the rest. Returns false if the client is gone.
+ */
+static bool flushClient(int fd, ExportClient& client) {
+    while (client.sent < client.out.size()) {
+        ssize_t n = send(fd, client.out.data() + client.sent, client.out.size() - client.sent,
+                         MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n > 0) {
+            client.sent += n;
+            client.written += n;
+        } else if (n == -1 && errno == EINTR) {
+            continue;
+        } else if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    if (client.sent == client.out.size()) {
+        client.out.clear();
+        client.sent = 0;
+    } else if (client.sent > client.out.size() / 2) {
+        client.out.erase(0, client.sent);
+        client.sent = 0;
+    }
+
+    bool want_out = !client.out.empty();
+    if (want_out != client.want_out) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN | EPOLLRDHUP | (want_out ? (uint32_t)EPOLLOUT : 0u);
+        ev.data.fd = fd;
+        if (epoll_ctl(stats_export_fd, EPOLL_CTL_MOD, fd, &ev) == -1) return false;
+        client.want_out = want_out;
+    }
+    return true;
+}
+
+/**
+ * @brief Queues `line` for one client and writes what it can. Drops the client if the
+ *        line would take its queue of live updates past EXPORT_MAX_BACKLOG; `initial`
+ *        lines (sent on connect) are exempt.
+ * @return false if the client was dropped.
+ */
+static bool sendLine(int fd, ExportClient& client, const string& line, bool initial) {
+    if (initial) {
+        client.initial_bytes += line.size();
+    } else {
+        uint64_t initial_left = client.initial_bytes > client.written ? client.initial_bytes - client.written : 0;
+        if (client.out.size() - client.sent - initial_left + line.size() > EXPORT_MAX_BACKLOG) {
+            dropClient(fd);
+            return false;
+        }
+    }
+    client.out += line;
+    if (!flushClient(fd, client)) {
+        dropClient(fd);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Queues `line` for every client (those with output still queued are skipped
+ *        if `skippable`).
+ */
+static void broadcastLine(const string& line, bool skippable) {
+    for (auto it = clients.begin(); it != clients.end();) {
+        int fd = it->first;
+        ExportClient& client = it->second;
+        ++it; // sendLine may erase this client
+        if (skippable && client.sent < client.out.size()) continue;
+        sendLine(fd, client, line, false);
+    }
+}
+
+/**
+ * @brief One snapshot line for race `race` of the arena. Elapsed time runs from the
+ *        race start (start_time_ms) to now, or to the last finish once the race is over;
+ *        step rates are steps per second over it.
+ */
+static void formatSnapshotLine(RaceShm* arena, int race, string& line) {
+    static RaceSnapshot snap;
+    takeRaceSnapshot(raceBlock(arena, race), snap);
+
+    long elapsed_ms = 0;
+    if (snap.start_time_ms != 0 && snap.status != READY) {
+        long end_ms = wall_clock_ms();
+        if (snap.status == FINISHED) {
+            end_ms = snap.start_time_ms;
+            for (int id : snap.finish_order) {
+                if (id > 0 && snap.racers[id - 1].finish_time_ms > end_ms) end_ms = snap.racers[id - 1].finish_time_ms;
+            }
+        }
+        elapsed_ms = end_ms - snap.start_time_ms;
+    }
+
+    char buf[256];
+    snprintf(buf, sizeof(buf), "{\"type\": \"snapshot\", \"race\": %d, \"seed\": %llu, \"status\": \"%s\", "
+                               "\"elapsed_ms\": %ld, \"consistent\": %s, \"finished\": %d, \"dnf\": %d, \"racers\": [",
+             race + 1, (unsigned long long)snap.race_seed, STATUS_NAMES[snap.status], elapsed_ms,
+             snap.consistent ? "true" : "false", snap.finish_count, snap.dnf_count);
+    line = buf;
+
+    for (int i = 0; i < NUM_RACERS; ++i) {
+        const RacerSnapshot& racer = snap.racers[i];
+        double rate = elapsed_ms > 0 ? racer.steps * 1000.0 / elapsed_ms : 0.0;
+        snprintf(buf, sizeof(buf), "%s{\"id\": %d, \"position\": %d, \"steps\": %d, \"steps_per_s\": %.1f%s}",
+                 i ? ", " : "", i + 1, racer.position, racer.steps, rate, racer.dnf ? ", \"dnf\": true" : "");
+        line += buf;
+    }
+    line += "], \"finish_order\": [";
+    for (size_t rank = 0; rank < snap.finish_order.size(); ++rank) {
+        snprintf(buf, sizeof(buf), "%s%d", rank ? ", " : "", snap.finish_order[rank]);
+        line += buf;
+    }
+    line += "]}\n";
+}
+
+/**
+ * @brief Accepts new subscribers (hello plus a snapshot of every race), writes queued
+ *        output and drops closed connections. Call whenever stats_export_fd polls
+ *        readable; it never blocks.
+ */
+void serviceStatsExport(RaceShm* arena) {
+    if (stats_export_fd == -1) return;
+
+    struct epoll_event events[EXPORT_EVENTS];
+    int ready;
+    while ((ready = epoll_wait(stats_export_fd, events, EXPORT_EVENTS, 0)) > 0) {
+        for (int e = 0; e < ready; ++e) {
+            int fd = events[e].data.fd;
+            if (fd == listen_fd) {
+                int client_fd;
+                while ((client_fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+                    struct epoll_event ev;
+                    ev.events = EPOLLIN | EPOLLRDHUP;
+                    ev.data.fd = client_fd;
+                    if ((int)clients.size() >= EXPORT_MAX_CLIENTS ||
+                        epoll_ctl(stats_export_fd, EPOLL_CTL_ADD, client_fd, &ev) == -1) {
+                        close(client_fd);
+                        continue;
+                    }
+                    char hello[256];
+                    snprintf(hello, sizeof(hello), "{\"type\": \"hello\", \"monitor_pid\": %d, \"racers\": %d, "
+                                                   "\"race_length\": %d, \"concurrent_races\": %d, \"podium\": %d, "
+                                                   "\"max_fps\": %d}\n",
+                             (int)getpid(), NUM_RACERS, RACE_LENGTH, CONCURRENT_RACES, PODIUM_SIZE, MAX_FPS);
+                    bool open = sendLine(client_fd, clients[client_fd], hello, true);
+                    string snapshot;
+                    for (int race = 0; open && race < CONCURRENT_RACES; ++race) {
+                        formatSnapshotLine(arena, race, snapshot);
+                        open = sendLine(client_fd, clients[client_fd], snapshot, true);
+                    }
+                }
+                continue;
+            }
+
+            auto it = clients.find(fd);
+            if (it == clients.end()) continue; // Dropped earlier in this batch
+            bool gone = (events[e].events & (EPOLLHUP | EPOLLERR | EPOLLRDHUP)) != 0;
+            if (!gone && (events[e].events & EPOLLIN)) {
+                // Subscribers have nothing to say: input is read and discarded
+                char discard[512];
+                ssize_t n;
+                while ((n = read(fd, discard, sizeof(discard))) > 0) {
+                }
+                gone = n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+            }
+            if (!gone && (events[e].events & EPOLLOUT)) {
+                gone = !flushClient(fd, it->second);
+            }
+            if (gone) dropClient(fd);
+        }
+        if (ready < EXPORT_EVENTS) break;
+    }
+}
+
+/**
+ * @brief Sends a snapshot of every race to the subscribers. The caller paces this
+ *        (frames / MAX_FPS); without subscribers it costs nothing.
+ */
+void publishStatsSnapshots(RaceShm* arena) {
+    if (clients.empty()) return;
+    string line;
+    for (int race = 0; race < CONCURRENT_RACES; ++race) {
+        formatSnapshotLine(arena, race, line);
+        broadcastLine(line, true);
+    }
+}
+
+/**
+ * @brief Sends a logged result of race `race` (0-based) to every subscriber.
+ */
+void publishStatsResult(int race, const RaceResult& result) {
+    if (clients.empty()) return;
+
+    char buf[256];
+    snprintf(buf, sizeof(buf), "{\"type\": \"result\", \"race\": %d, \"seed\": %llu, \"start_time_ms\": %ld, "
+                               "\"winner\": %d, \"duration_ms\": %ld, \"finish_order\": [",
+             race + 1, (unsigned long long)result.seed, result.start_time_ms, result.winner, result.duration_ms);
+    string line = buf;
+    for (size_t rank = 0; rank < result.finish_order.size(); ++rank) {
+        snprintf(buf, sizeof(buf), "%s[%d, %ld]", rank ? ", " : "", result.finish_order[rank], result.finish_ms[rank]);
+        line += buf;
+    }
+    line += "], \"steps\": [";
+    for (size_t i = 0; i < result.steps.size(); ++i) {
+        snprintf(buf, sizeof(buf), "%s%d", i ? ", " : "", result.steps[i]);
+        line += buf;
+    }
+    line += "]}\n";
+    broadcastLine(line, false);
+}
+
+/**
+ * @brief Says goodbye to the subscribers (best effort), closes everything and removes
+ *        the socket.
+ */
+void closeStatsExport() {
+    if (!clients.empty()) broadcastLine("{\"type\": \"exit\"}\n", false);
+    dropStatsExport();
+    if (!socket_path.empty()) {
+        unlink(socket_path.c_str());
+        socket_path.clear();
+    }
+}
@@ -1,4 +1,6 @@
 #include "RaceLogic.h"
+#include "RaceRng.h"
+#include "RaceProfiles.h"
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
@@ -6,233 +8,1113 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
 #include <sys/shm.h>
 #include <string>
+#include <vector>
+#include <sched.h>
 #include <signal.h>
 #include <ncurses.h>
 #include <chrono>
+#include <climits>
+#include <cstdio>
+#include <algorithm>
+#include <cerrno>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 using namespace std;
 
-// --- CONFIGURATION (DEFINITIONS) ---
-const int RACE_LENGTH = 100;
-const int NUM_RACERS = 4;
+// Configuration and shared memory layout are defined in RaceConfig.cpp
 
-// --- Shared Memory Index Definitions (Definitions) ---
-const int POS_OFFSET = 0;
-const int PID_OFFSET = NUM_RACERS;
-const int STATUS_INDEX = NUM_RACERS * 2;
-const int START_TIME_INDEX = STATUS_INDEX + 1;
-
-// SHM_SIZE: NUM_RACERS (positions) + NUM_RACERS (PIDs) + 1 (Status) + 1 (Start Time)
-const size_t SHM_SIZE = sizeof(int) * (NUM_RACERS * 2) + sizeof(int) + sizeof(long);
+// eventfd racers signal when the monitor sleeps (SYNC_EVENT mode). Created by the
+// monitor before forking so every racer inherits it.
+int race_event_fd = -1;
 
+// How long an idle monitor sleeps in views that show data other processes may
+// change (the results log), so their updates still appear
+const int IDLE_REFRESH_MS = 1000;
 
 // --- EXTERNAL FUNCTION PROTOTYPES (Defined elsewhere) ---
 // Defined in NcursesGui.cpp
 void initNcurses();
 void endNcurses();
-void drawRaceTrackGUI(int* shm_ptr, int winner_id, int current_view);
+void drawRaceTrackGUI(RaceShm* shm, int winner_id);
 void drawResultsGUI();
-// Defined in main.cpp
-void start_race_processes(int shmid);
+void drawStatsGUI(RaceShm* shm);
+void drawAnalyticsGUI();
+void drawRaceGridGUI(RaceShm* arena, int selected, long races_completed);
+int raceGridColumns();
+void setTrackLane(int lane);
+void scrollRaceTrackGUI(int delta);
 
 // ----------------------------------------------------------------------
-// --- LOGGING ---
+// --- SYNCHRONIZATION (FUTEX ON THE STATUS WORD + EVENTFD TO THE MONITOR) ---
 // ----------------------------------------------------------------------
 
+// The status word in shared memory doubles as a futex: racers sleep on it while
+// the race is READY/PAUSED (and during their step delay), and every status change
+// made through setRaceStatus() wakes them immediately. The futex is not
+// FUTEX_PRIVATE because the word lives in a segment shared between processes.
+
+static long futex(int* addr, int op, int val, const struct timespec* timeout) {
+    return syscall(SYS_futex, addr, op, val, timeout, nullptr, 0);
+}
+
+/**
+ * @brief Atomically reads the race status from shared memory.
+ */
+int getRaceStatus(RaceShm* shm) {
+    return __atomic_load_n(&shm->status, __ATOMIC_ACQUIRE);
+}
+
 /**
- * @brief Logs the race result (winner and duration) to a file.
+ * @brief Wakes every racer waiting on the status word (event sync only).
  */
-void logRaceResult(int winner_id, long duration_ms) {
-    ofstream outfile("race_results.txt", ios::app);
-    if (outfile.is_open()) {
-        time_t now = time(nullptr);
-        char dt[20];
-        strftime(dt, 20, "%Y-%m-%d %H:%M:%S", localtime(&now));
+static void wakeStatusWaiters(RaceShm* shm) {
+    if (SYNC_MODE == SYNC_EVENT) {
+        futex(&shm->status, FUTEX_WAKE, INT_MAX, nullptr);
+    }
+}
+
+/**
+ * @brief Stores a new race status and wakes every racer waiting on it.
+ */
+void setRaceStatus(RaceShm* shm, int status) {
+    // Stamped before the store so a racer that sees the new status also sees its time
+    __atomic_store_n(&shm->status_changed_us, monotonic_us(), __ATOMIC_RELAXED);
+    __atomic_store_n(&shm->status, status, __ATOMIC_RELEASE);
+    wakeStatusWaiters(shm);
+}
+
+/**
+ * @brief Moves the status from `from` to `to` only if it still is `from`, and wakes
+ *        the racers. Concurrent transitions (a racer closing the race, the monitor
+ *        pausing it) are never overwritten. Returns true if this call made the change.
+ */
+static bool changeRaceStatus(RaceShm* shm, int from, int to) {
+    __atomic_store_n(&shm->status_changed_us, monotonic_us(), __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&shm->status, &from, to, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+    wakeStatusWaiters(shm);
+    return true;
+}
+
+/**
+ * @brief Sleeps while the status still equals `expected`, for at most timeout_us
+ *        (negative = no timeout). Returns early on any status change.
+ */
+static void waitForStatusChange(RaceShm* shm, int expected, long timeout_us) {
+    struct timespec ts;
+    struct timespec* tsp = nullptr;
+    if (timeout_us >= 0) {
+        ts.tv_sec = timeout_us / 1000000;
+        ts.tv_nsec = (timeout_us % 1000000) * 1000;
+        tsp = &ts;
+    }
+    // EAGAIN (status already changed), EINTR and ETIMEDOUT all just return to the caller
+    futex(&shm->status, FUTEX_WAIT, expected, tsp);
+}
+
+/**
+ * @brief Creates the racer -> monitor eventfd. Must run before racers are forked.
+ */
+bool initRaceEvents() {
+    if (SYNC_MODE != SYNC_EVENT) return true;
+    race_event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (race_event_fd == -1) {
+        perror("eventfd failed");
+        return false;
+    }
+    return true;
+}
+
+void closeRaceEvents() {
+    if (race_event_fd != -1) {
+        close(race_event_fd);
+        race_event_fd = -1;
+    }
+}
+
+/**
+ * @brief Tells the monitor that race `shm` changed (a racer moved or finished): bumps
+ *        the change counter, and only if the monitor is blocked, wakes it through the
+ *        eventfd. Of all racers that bump while it sleeps, one pays for the write.
+ *
+ *        The counter bump and the monitor's flag store are both seq_cst, so either
+ *        this racer sees monitor_waiting, or the monitor sees the new count when it
+ *        re-checks after arming (see armMonitorWakeup); no wakeup is lost.
+ */
+void notifyMonitor(RaceShm* shm) {
+    __atomic_add_fetch(&shm->change_seq, 1, __ATOMIC_SEQ_CST);
+    if (race_event_fd == -1 || __atomic_load_n(&shm->monitor_waiting, __ATOMIC_SEQ_CST) == 0) return;
+    if (__atomic_exchange_n(&shm->monitor_waiting, 0, __ATOMIC_SEQ_CST) == 0) return;
+
+    uint64_t one = 1;
+    // A full counter (EAGAIN) still leaves the monitor readable, so the error is ignored
+    if (write(race_event_fd, &one, sizeof(one)) == -1) {
+        return;
+    }
+}
+
+/**
+ * @brief Sum of the change counters of every race in the arena: it moves whenever any
+ *        racer stepped or finished.
+ */
+static uint64_t raceChangeSeq(RaceShm* arena) {
+    uint64_t seq = 0;
+    for (int race = 0; race < CONCURRENT_RACES; ++race) {
+        seq += __atomic_load_n(&raceBlock(arena, race)->change_seq, __ATOMIC_SEQ_CST);
+    }
+    return seq;
+}
+
+/**
+ * @brief Asks the racers of every race to write the eventfd on their next change. The
+ *        caller must re-check raceChangeSeq() afterwards and only block if it is unchanged.
+ */
+static uint64_t armMonitorWakeup(RaceShm* arena) {
+    for (int race = 0; race < CONCURRENT_RACES; ++race) {
+        __atomic_store_n(&raceBlock(arena, race)->monitor_waiting, 1, __ATOMIC_SEQ_CST);
+    }
+    return raceChangeSeq(arena);
+}
+
+/**
+ * @brief Ends a blocking wait: racers go back to only bumping the counters, and any
+ *        wakeup already written is drained.
+ */
+static void disarmMonitorWakeup(RaceShm* arena) {
+    for (int race = 0; race < CONCURRENT_RACES; ++race) {
+        __atomic_store_n(&raceBlock(arena, race)->monitor_waiting, 0, __ATOMIC_RELAXED);
+    }
+    uint64_t count;
+    if (read(race_event_fd, &count, sizeof(count)) == -1) {
+        // EAGAIN: no racer needed to wake us
+    }
+}
+
+// ----------------------------------------------------------------------
+// --- FINISH PROTOCOL (LOCK-FREE) ---
+// ----------------------------------------------------------------------
+
+// A finishing racer stamps its finish time, takes the next slot of the finish
+// order with an atomic fetch-add on finish_count and publishes its id in
+// that slot. The racer that fills the podium closes the race with a CAS on the
+// status word, so exactly one process performs the RUNNING -> FINISHED
+// transition and the order reflects who actually crossed the line first.
+
+/**
+ * @brief Finishers needed to end the race: PODIUM_SIZE (0 = everyone), capped by the
+ *        racers still able to finish once DNFs are taken out.
+ */
+static int effectivePodium(RaceShm* shm) {
+    int podium = (PODIUM_SIZE == 0 || PODIUM_SIZE > NUM_RACERS) ? NUM_RACERS : PODIUM_SIZE;
+    int can_finish = NUM_RACERS - __atomic_load_n(&shm->dnf_count, __ATOMIC_ACQUIRE);
+    return podium < can_finish ? podium : can_finish;
+}
+
+/**
+ * @brief Moves a RUNNING/PAUSED race to FINISHED. A pause may race us, so retry until
+ *        the status is neither (FINISHED or EXITING are left alone).
+ */
+static void closeRace(RaceShm* shm) {
+    int status = getRaceStatus(shm);
+    while ((status == RUNNING || status == PAUSED) && !changeRaceStatus(shm, status, FINISHED)) {
+        status = getRaceStatus(shm);
+    }
+}
+
+/**
+ * @brief Records racer_id as finished. Its finish time is already in its slot (see
+ *        publishStep). Returns its 1-based finishing place.
+ */
+static int claimFinish(RaceShm* shm, int racer_id) {
+    int rank = __atomic_fetch_add(&shm->finish_count, 1, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&finishOrder(shm)[rank], racer_id, __ATOMIC_RELEASE);
+
+    if (rank + 1 >= effectivePodium(shm)) {
+        closeRace(shm);
+    }
+    return rank + 1;
+}
 
-        outfile << dt << " | Winner: Racer " << winner_id
-                << " | Duration: " << (double)duration_ms / 1000.0 << "s" << endl;
-        outfile.close();
+/**
+ * @brief Marks a racer that died mid-race as DNF (called by the monitor's reaper).
+ *        Closes the race if the remaining racers can no longer fill the podium.
+ */
+void markRacerDnf(RaceShm* shm, int racer_id) {
+    RacerSlot* slot = racerSlot(shm, racer_id - 1);
+    if (__atomic_exchange_n(&slot->dnf, 1, __ATOMIC_ACQ_REL) != 0) return;
+    __atomic_add_fetch(&shm->dnf_count, 1, __ATOMIC_ACQ_REL);
+
+    if (__atomic_load_n(&shm->finish_count, __ATOMIC_ACQUIRE) >= effectivePodium(shm)) {
+        closeRace(shm);
+    }
+}
+
+// ----------------------------------------------------------------------
+// --- CONSISTENT SNAPSHOTS ---
+// ----------------------------------------------------------------------
+
+// Readers (TUI, results logger, exporters) never read racer slots field by field.
+// takeRaceSnapshot() copies every slot through its seqlock, then checks that no
+// slot sequence, status or finish/DNF counter moved during the copy (a double
+// collect): if nothing did, the copy is the race as it was at one instant, e.g.
+// FINISHED always comes with its winner at RACE_LENGTH. Writers never wait, and
+// readers give up after a bounded number of attempts, keeping the last copy, in
+// which each racer is still internally consistent.
+
+const int SNAPSHOT_ATTEMPTS = 8;   // Validated collects tried before settling for the last one
+const int SLOT_READ_SPINS = 64;    // Retries of one slot while its writer is mid-step
+
+/**
+ * @brief Copies one slot through its seqlock. Returns the even sequence the copy is
+ *        valid for, or an odd value if the writer stayed busy through every retry.
+ */
+static uint32_t readRacerSlot(RacerSlot* slot, RacerSnapshot& out) {
+    uint32_t seq = 1;
+    for (int spin = 0; spin < SLOT_READ_SPINS; ++spin) {
+        seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        out.position = __atomic_load_n(&slot->position, __ATOMIC_RELAXED);
+        out.pid = __atomic_load_n(&slot->pid, __ATOMIC_RELAXED);
+        out.steps = __atomic_load_n(&slot->steps, __ATOMIC_RELAXED);
+        out.finish_time_ms = __atomic_load_n(&slot->finish_time_ms, __ATOMIC_RELAXED);
+        out.last_step_us = __atomic_load_n(&slot->last_step_us, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if ((seq & 1) == 0 && __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq) return seq;
+        if (spin >= 8) sched_yield(); // The writer was preempted mid-step
+    }
+    return seq | 1;
+}
+
+/**
+ * @brief Copies race `shm` into `snap` (whose vectors are reused, so repeated
+ *        snapshots do not allocate). A racer that has taken a finishing place but not
+ *        yet published its id is waited for (bounded), so a podium never has holes.
+ * @return snap.consistent: true if the copy is the race at a single instant.
+ */
+bool takeRaceSnapshot(RaceShm* shm, RaceSnapshot& snap) {
+    thread_local vector<uint32_t> seqs;
+    seqs.resize(NUM_RACERS);
+    snap.racers.resize(NUM_RACERS);
+
+    snap.consistent = false;
+    for (int attempt = 0; attempt < SNAPSHOT_ATTEMPTS && !snap.consistent; ++attempt) {
+        snap.status = getRaceStatus(shm);
+        snap.finish_count = __atomic_load_n(&shm->finish_count, __ATOMIC_ACQUIRE);
+        snap.dnf_count = __atomic_load_n(&shm->dnf_count, __ATOMIC_ACQUIRE);
+
+        bool whole = true;
+        for (int i = 0; i < NUM_RACERS; ++i) {
+            RacerSlot* slot = racerSlot(shm, i);
+            seqs[i] = readRacerSlot(slot, snap.racers[i]);
+            snap.racers[i].dnf = __atomic_load_n(&slot->dnf, __ATOMIC_ACQUIRE);
+            whole = whole && (seqs[i] & 1) == 0;
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        // Second collect: valid only if nothing moved while the racers were copied
+        bool unchanged = whole && getRaceStatus(shm) == snap.status &&
+                         __atomic_load_n(&shm->finish_count, __ATOMIC_ACQUIRE) == snap.finish_count &&
+                         __atomic_load_n(&shm->dnf_count, __ATOMIC_ACQUIRE) == snap.dnf_count;
+        for (int i = 0; unchanged && i < NUM_RACERS; ++i) {
+            unchanged = __atomic_load_n(&racerSlot(shm, i)->seq, __ATOMIC_RELAXED) == seqs[i];
+        }
+        snap.consistent = unchanged;
+    }
+    snap.race_seed = shm->race_seed;
+    snap.start_time_ms = shm->start_time_ms;
+
+    int finished = snap.finish_count < NUM_RACERS ? snap.finish_count : NUM_RACERS;
+    snap.finish_order.assign(finished, 0);
+    for (int rank = 0; rank < finished; ++rank) {
+        int id = 0;
+        for (int spins = 0; spins < 1000 && id == 0; ++spins) {
+            id = __atomic_load_n(&finishOrder(shm)[rank], __ATOMIC_ACQUIRE);
+            if (id == 0) sched_yield();
+        }
+        snap.finish_order[rank] = id;
+    }
+    return snap.consistent;
+}
+
+/**
+ * @brief Seed for the next race: RACE_SEED for the first one (random unless --seed
+ *        was given), then a deterministic chain so a whole batch replays from it.
+ */
+static uint64_t nextRaceSeed() {
+    static bool first = true;
+    static uint64_t seed;
+    if (first) {
+        seed = RACE_SEED_SET ? RACE_SEED : mix64((uint64_t)wall_clock_ms() ^ ((uint64_t)getpid() << 32));
+        first = false;
     } else {
-        cerr << "Error: Could not open race_results.txt for logging." << endl;
+        seed = nextSeed(seed);
+    }
+    return seed;
+}
+
+/**
+ * @brief Clears positions, PIDs and the finish bookkeeping before a new race and
+ *        picks the race seed.
+ */
+void resetRaceState(RaceShm* shm) {
+    for (int i = 0; i < NUM_RACERS; ++i) {
+        RacerSlot* slot = racerSlot(shm, i);
+        racerSlotWriteBegin(slot);
+        __atomic_store_n(&slot->pid, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&slot->position, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&slot->finish_time_ms, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&slot->steps, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&slot->last_step_us, 0, __ATOMIC_RELAXED);
+        racerSlotWriteEnd(slot);
+        slot->dnf = 0;
+        finishOrder(shm)[i] = 0;
     }
+    __atomic_store_n(&shm->finish_count, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&shm->dnf_count, 0, __ATOMIC_RELEASE);
+    shm->race_seed = nextRaceSeed(); // Published to racers by the READY/generation release
+}
+
+/**
+ * @brief Builds the result of the race that just finished (finish order, times, steps).
+ */
+RaceResult collectRaceResult(RaceShm* shm) {
+    RaceSnapshot snap;
+    takeRaceSnapshot(shm, snap);
+
+    RaceResult result;
+    result.timestamp = time(nullptr);
+    result.start_time_ms = snap.start_time_ms;
+    result.finish_order = snap.finish_order;
+    result.winner = result.finish_order.empty() ? 0 : result.finish_order[0];
+    result.seed = snap.race_seed;
+    for (int id : snap.finish_order) {
+        long t = id > 0 ? snap.racers[id - 1].finish_time_ms : 0;
+        result.finish_ms.push_back(t - snap.start_time_ms);
+    }
+    result.duration_ms = result.finish_ms.empty() ? 0 : result.finish_ms[0];
+    for (const RacerSnapshot& racer : snap.racers) {
+        result.steps.push_back(racer.steps);
+    }
+    return result;
 }
 
 // ----------------------------------------------------------------------
 // --- RACER PROCESS LOGIC (CHILD) ---
 // ----------------------------------------------------------------------
 
-void runRacer(int racer_id, int shmid) {
-    int* shm_ptr = (int*)shmat(shmid, nullptr, 0);
-    if (shm_ptr == (int*)-1) {
-        perror("Racer shmat failed");
-        exit(EXIT_FAILURE);
+/**
+ * @brief Step size of a draw: the racer's profile, or the built-in 1-4 without one.
+ */
+static int drawStep(const RacerProfile* profile, uint64_t draw) {
+    return profile != nullptr ? profileStep(*profile, draw) : racerStep(draw);
+}
+
+/**
+ * @brief Delay after a step (the profile's, or 250-400 ms, from the step's draw and the
+ *        position it reached), scaled by DELAY_SCALE.
+ */
+static long stepDelayUs(const RacerProfile* profile, const RacerRng& rng, uint64_t draw, int position) {
+    long us = profile != nullptr ? profileDelayUs(*profile, rng.key, rng.counter, draw, position) : racerDelayUs(draw);
+    return (long)(us * DELAY_SCALE);
+}
+
+/**
+ * @brief CPU time used by the calling thread (the whole racer for a forked racer).
+ */
+static long thread_cpu_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief STEP_WORK delay: spins until this racer has used cpu_us of CPU time, so a racer
+ *        that gets a smaller share of a core falls behind in wall time. With `shm` it
+ *        stops as soon as the status leaves RUNNING and returns the CPU time still owed.
+ */
+static long burnCpuUs(RaceShm* shm, long cpu_us) {
+    long target = thread_cpu_us() + cpu_us;
+    uint64_t x = (uint64_t)target;
+    while (true) {
+        for (int i = 0; i < 256; ++i) {
+            x = mix64(x + i);
+        }
+        __asm__ __volatile__("" : : "r"(x)); // Keep the work from being optimized away
+
+        long now = thread_cpu_us();
+        if (now >= target) return 0;
+        if (shm != nullptr && getRaceStatus(shm) != RUNNING) return target - now;
+    }
+}
+
+// ----------------------------------------------------------------------
+// --- RACER INSTRUMENTATION ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief Reads the status and, when it differs from the last one this racer saw,
+ *        records how long after setRaceStatus() the change was observed.
+ */
+static int observeStatus(RaceShm* shm, int& seen) {
+    int status = getRaceStatus(shm);
+    if (status != seen) {
+        int hist = -1;
+        if (status == RUNNING) hist = HIST_SEEN_RUNNING;
+        else if (status == PAUSED) hist = HIST_SEEN_PAUSED;
+        else if (status == FINISHED) hist = HIST_SEEN_FINISHED;
+        else if (status == EXITING) hist = HIST_SEEN_EXITING;
+        if (hist >= 0) {
+            long changed_us = __atomic_load_n(&shm->status_changed_us, __ATOMIC_RELAXED);
+            recordLatency(&raceStats(shm)->hist[hist], monotonic_us() - changed_us);
+        }
+        seen = status;
+    }
+    return status;
+}
+
+// slot->cpu_us minus this racer's CPU clock at the start of the race (see runRacer)
+static thread_local long racer_cpu_base_us = 0;
+
+/**
+ * @brief Appends a step to the racer's trace ring (--record). Plain stores only: if the
+ *        monitor has fallen a full ring behind, the event is counted as dropped.
+ */
+static void traceStep(RaceShm* shm, int racer_id, long t_us, int position) {
+    int size = shm->trace_ring_size;
+    if (size == 0) return;
+
+    TraceRing* ring = traceRing(shm, racer_id - 1);
+    uint32_t head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= (uint32_t)size) {
+        ring->dropped++;
+        return;
     }
+    TraceEvent* event = &traceEvents(ring)[head & (size - 1)];
+    event->t_us = t_us;
+    event->position = position;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Publishes the racer's CPU time and tracks which CPU its steps run on. Updated
+ *        per step because a losing fork-backend racer is killed, not returned from.
+ */
+static void noteCpu(RacerSlot* slot) {
+    slot->cpu_us = racer_cpu_base_us + thread_cpu_us();
 
-    int position_index = POS_OFFSET + racer_id - 1;
-    int pid_index = PID_OFFSET + racer_id - 1;
+    int cpu = sched_getcpu();
+    if (cpu != slot->cpu) {
+        if (slot->cpu >= 0) slot->migrations++;
+        slot->cpu = (int16_t)cpu;
+    }
+}
 
-    // Store PID and initialize position
-    shm_ptr[pid_index] = getpid();
-    shm_ptr[position_index] = 0;
+static void notePause(RaceShm* shm, RacerSlot* slot, long paused_from_us) {
+    long paused = monotonic_us() - paused_from_us;
+    slot->paused_us += paused;
+    recordLatency(&raceStats(shm)->hist[HIST_PAUSE], paused);
+}
 
-    srand(getpid() * time(NULL));
+/**
+ * @brief Publishes one step of racer_id: step count, time, position and (on crossing
+ *        the line) finish time go out together under the slot seqlock, then the
+ *        finishing place is claimed. Returns true if the racer finished.
+ */
+static bool publishStep(RaceShm* shm, int racer_id, RacerSlot* slot, int new_pos) {
+    bool finished = new_pos >= RACE_LENGTH;
+    if (finished) new_pos = RACE_LENGTH;
+
+    long step_us = monotonic_us();
+    noteCpu(slot);
+    traceStep(shm, racer_id, step_us, new_pos);
+
+    racerSlotWriteBegin(slot);
+    __atomic_store_n(&slot->steps, slot->steps + 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->last_step_us, step_us, __ATOMIC_RELAXED);
+    if (finished) __atomic_store_n(&slot->finish_time_ms, wall_clock_ms(), __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->position, new_pos, __ATOMIC_RELEASE);
+    racerSlotWriteEnd(slot);
+
+    if (finished) claimFinish(shm, racer_id);
+    return finished;
+}
+
+/**
+ * @brief Original racer loop: polls the status word and sleeps with usleep (SYNC_POLL mode).
+ */
+static void runRacerPollLoop(RaceShm* shm, int racer_id, RacerSlot* slot, RacerRng& rng,
+                             const RacerProfile* profile) {
+    int seen = READY; // Every race starts from READY
 
-    // Race Loop: runs until position hits RACE_LENGTH or status is EXITING
-    while (shm_ptr[position_index] < RACE_LENGTH && shm_ptr[STATUS_INDEX] != EXITING) {
+    // Race Loop: runs until position hits RACE_LENGTH or status is EXITING/FINISHED
+    while (slot->position < RACE_LENGTH && observeStatus(shm, seen) != EXITING) {
 
         // PAUSE/RESUME Logic: loop while status is PAUSED
-        while (shm_ptr[STATUS_INDEX] == PAUSED) {
-            usleep(100000); // 100ms sleep while paused
+        if (seen == PAUSED) {
+            long paused_from = monotonic_us();
+            while (observeStatus(shm, seen) == PAUSED) {
+                usleep(100000); // 100ms sleep while paused
+            }
+            notePause(shm, slot, paused_from);
         }
 
         // Only move if RUNNING
-        if (shm_ptr[STATUS_INDEX] == RUNNING) {
-            int step = (rand() % 4) + 1;
-            int current_pos = shm_ptr[position_index];
-
-            // Update position in shared memory
-            shm_ptr[position_index] = current_pos + step;
+        int status = observeStatus(shm, seen);
+        if (status == RUNNING && __atomic_load_n(&slot->dnf, __ATOMIC_RELAXED)) {
+            break; // Scratched before the start (an empty lane of a tournament heat)
+        } else if (status == RUNNING) {
+            uint64_t draw = rng.next();
+            int new_pos = slot->position + drawStep(profile, draw);
 
-            if (shm_ptr[position_index] >= RACE_LENGTH) {
-                shm_ptr[position_index] = RACE_LENGTH;
+            // Update position in our own slot (single writer, seqlocked stores)
+            bool finished = publishStep(shm, racer_id, slot, new_pos);
+            notifyMonitor(shm); // Only bumps the change counter: poll mode has no eventfd
+            if (finished) break;
 
-                // Set race status to FINISHED
-                if (shm_ptr[STATUS_INDEX] == RUNNING) {
-                    shm_ptr[STATUS_INDEX] = FINISHED;
-                }
+            // Delay
+            long delay_us = stepDelayUs(profile, rng, draw, new_pos);
+            if (delay_us > 0) {
+                if (STEP_MODE == STEP_WORK) burnCpuUs(nullptr, delay_us);
+                else usleep(delay_us);
             }
+        } else if (status == EXITING || status == FINISHED) {
+            break;
+        }
+    }
+}
 
-            // Delay
-            usleep(250000 + (rand() % 150000));
-        } else if (shm_ptr[STATUS_INDEX] == EXITING) {
+/**
+ * @brief Event-driven racer loop (SYNC_EVENT mode). Paused/ready racers block on the
+ *        status futex, and the step delay is a futex wait so pause/exit interrupt it.
+ *        A paused delay resumes with its remaining time, so pausing never shortens it.
+ */
+static void runRacerEventLoop(RaceShm* shm, int racer_id, RacerSlot* slot, RacerRng& rng,
+                              const RacerProfile* profile) {
+    int seen = READY; // Every race starts from READY
+
+    while (slot->position < RACE_LENGTH) {
+        int status = observeStatus(shm, seen);
+
+        if (status == EXITING || status == FINISHED) {
             break;
         }
+        if (status != RUNNING) {
+            // READY or PAUSED: sleep until the monitor changes the status
+            long paused_from = monotonic_us();
+            waitForStatusChange(shm, status, -1);
+            if (status == PAUSED) notePause(shm, slot, paused_from);
+            continue;
+        }
+        if (__atomic_load_n(&slot->dnf, __ATOMIC_RELAXED)) {
+            break; // Scratched before the start (an empty lane of a tournament heat)
+        }
+
+        uint64_t draw = rng.next();
+        int new_pos = slot->position + drawStep(profile, draw);
+
+        // Update position in our own slot (single writer, seqlocked stores)
+        bool finished = publishStep(shm, racer_id, slot, new_pos);
+        notifyMonitor(shm);
+        if (finished) break;
+
+        // Delay: wait on the status word (or burn CPU while watching it) so a pause or
+        // exit interrupts it immediately
+        long remaining_us = stepDelayUs(profile, rng, draw, new_pos);
+        while (remaining_us > 0) {
+            if (STEP_MODE == STEP_WORK) {
+                remaining_us = burnCpuUs(shm, remaining_us);
+            } else {
+                long started = monotonic_us();
+                waitForStatusChange(shm, RUNNING, remaining_us);
+                remaining_us -= monotonic_us() - started;
+            }
+
+            status = observeStatus(shm, seen);
+            if (status == PAUSED) {
+                long paused_from = monotonic_us();
+                waitForStatusChange(shm, PAUSED, -1);
+                notePause(shm, slot, paused_from);
+                observeStatus(shm, seen); // Time the resume now, not after the rest of the delay
+            } else if (status != RUNNING) {
+                break; // FINISHED or EXITING: the outer loop exits
+            }
+        }
     }
+}
+
+/**
+ * @brief Runs one race for racer_id against shm. Shared by every backend: a forked
+ *        child calls it once, a pooled racer thread once per race generation.
+ */
+void runRacer(int racer_id, RaceShm* shm) {
+    RacerSlot* slot = racerSlot(shm, racer_id - 1);
 
-    if (shmdt(shm_ptr) == -1) {
-        perror("Racer shmdt failed");
+    // Store PID (the thread id for pooled racers) and initialize position
+    pid_t tid = (pid_t)syscall(SYS_gettid);
+    racerSlotWriteBegin(slot);
+    __atomic_store_n(&slot->pid, tid, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->position, 0, __ATOMIC_RELAXED);
+    racerSlotWriteEnd(slot);
+    slot->cpu = -1;
+    racer_cpu_base_us = slot->cpu_us - thread_cpu_us();
+
+    // This racer's stream of the race seed: the same seed (and profile) replays the same
+    // steps and delays
+    RacerRng rng(shm->race_seed, racer_id);
+    const RacerProfile* profile = racerProfile(racer_id);
+
+    if (SYNC_MODE == SYNC_EVENT) {
+        runRacerEventLoop(shm, racer_id, slot, rng, profile);
+    } else {
+        runRacerPollLoop(shm, racer_id, slot, rng, profile);
     }
+    slot->cpu_us = racer_cpu_base_us + thread_cpu_us();
 }
 
 // ----------------------------------------------------------------------
 // --- MONITOR/PARENT PROCESS LOGIC (GUI) ---
 // ----------------------------------------------------------------------
 
-void runDisplayParent(int shmid) {
-    int* shm_ptr = (int*)shmat(shmid, nullptr, 0);
-    if (shm_ptr == (int*)-1) {
-        perror("Monitor shmat failed");
-        exit(EXIT_FAILURE);
+// Monitor views. With --concurrent the grid of all races is the home view and the
+// other views show the selected race.
+enum MonitorView {
+    VIEW_TRACK = 0,     // Race/Control view
+    VIEW_RESULTS = 1,
+    VIEW_STATS = 2,     // Latency stats
+    VIEW_ANALYTICS = 3, // Results analytics
+    VIEW_GRID = 4       // Summary grid of the concurrent races
+};
+
+/**
+ * @brief Starts a new race (from READY or FINISHED) or resumes a paused one.
+ * @return true if a new race was started.
+ */
+static bool startOrResumeRace(RaceShm* shm) {
+    int status = getRaceStatus(shm);
+    if (status == READY || status == FINISHED) {
+        // Start new race: Fork processes. The start time is recorded before RUNNING
+        // publishes it, as racers time their finish against it.
+        start_race_processes(shm);
+        shm->start_time_ms = wall_clock_ms();
+        setRaceStatus(shm, RUNNING);
+        return true;
+    } else if (status == PAUSED) {
+        // Resume race, unless a racer closed it since the read above
+        changeRaceStatus(shm, PAUSED, RUNNING);
+    }
+    return false;
+}
+
+/**
+ * @brief Ends the monitor: every race goes to EXITING.
+ */
+static void exitAllRaces(RaceShm* arena) {
+    for (int race = 0; race < CONCURRENT_RACES; ++race) {
+        setRaceStatus(raceBlock(arena, race), EXITING);
     }
+}
 
-    // Initialize start time to zero
-    // Note: The START_TIME_INDEX is sizeof(int) * 2 + sizeof(long) away from the start
-    // We must cast the pointer appropriately to handle the long value correctly
-    long* shm_long_ptr = (long*)(shm_ptr + START_TIME_INDEX); 
-    *shm_long_ptr = 0;
+/**
+ * @brief Applies one key press to the race state / current view. `selected` is the
+ *        race (arena block) the track, stats and grid keys act on. Races started here
+ *        get their `result_logged` flag cleared.
+ */
+static void handleMonitorKey(int ch, RaceShm* arena, int& selected, int& current_view, vector<bool>& result_logged) {
+    RaceShm* shm = raceBlock(arena, selected);
+    int home_view = CONCURRENT_RACES > 1 ? VIEW_GRID : VIEW_TRACK;
 
-    initNcurses();
+    // --- Global Input Handling ('Q' for exit/pause) ---
+    if (ch == 'q' || ch == 'Q') {
+        bool paused = false;
+        for (int race = 0; race < CONCURRENT_RACES; ++race) {
+            RaceShm* target = raceBlock(arena, race);
+            if (current_view != VIEW_GRID && target != shm) continue;
+            // If running, 'Q' acts as a Pause/Soft Stop first
+            if (changeRaceStatus(target, RUNNING, PAUSED)) paused = true;
+        }
+        if (!paused) {
+             // Exit immediately from READY, PAUSED, FINISHED, or HISTORY views
+             exitAllRaces(arena);
+        }
+    }
 
-    int current_view = 0; // 0: Race/Control, 1: Results
+    // --- View Specific Input Handling ---
 
-    // Main GUI Loop
-    while (shm_ptr[STATUS_INDEX] != EXITING) {
+    if (current_view == VIEW_TRACK || current_view == VIEW_GRID) {
+        if (ch == 's' || ch == 'S') {
+            if (startOrResumeRace(shm)) result_logged[selected] = false;
+        } else if (ch == 'p' || ch == 'P') {
+            // Conditional Pause: only works when RUNNING
+            changeRaceStatus(shm, RUNNING, PAUSED);
+        } else if (ch == 'r' || ch == 'R') {
+             // Switch to Results view
+            current_view = VIEW_RESULTS;
+        } else if (ch == 't' || ch == 'T') {
+            // Switch to the latency stats view
+            current_view = VIEW_STATS;
+        } else if (ch == 'a' || ch == 'A') {
+            // Switch to the results analytics view
+            current_view = VIEW_ANALYTICS;
+        }
+    }
 
-        int ch = getch(); // Read non-blocking input
+    if (current_view == VIEW_TRACK) {
+        if (ch == KEY_UP || ch == KEY_DOWN || ch == KEY_PPAGE || ch == KEY_NPAGE) {
+            // Scroll the track when there are more racers than screen rows
+            int page = 10;
+            if (ch == KEY_UP) scrollRaceTrackGUI(-1);
+            else if (ch == KEY_DOWN) scrollRaceTrackGUI(1);
+            else if (ch == KEY_PPAGE) scrollRaceTrackGUI(-page);
+            else scrollRaceTrackGUI(page);
+        } else if ((ch == 'b' || ch == 'B') && home_view == VIEW_GRID) {
+            current_view = VIEW_GRID;
+        }
+    } else if (current_view == VIEW_GRID) {
+        int columns = raceGridColumns();
+        int moved = selected;
+        if (ch == KEY_LEFT) moved--;
+        else if (ch == KEY_RIGHT) moved++;
+        else if (ch == KEY_UP) moved -= columns;
+        else if (ch == KEY_DOWN) moved += columns;
+        if (moved >= 0 && moved < CONCURRENT_RACES) selected = moved;
 
-        // --- Global Input Handling ('Q' for exit/pause) ---
-        if (ch == 'q' || ch == 'Q') {
-            if (shm_ptr[STATUS_INDEX] == RUNNING) {
-                // If running, 'Q' acts as a Pause/Soft Stop first
-                shm_ptr[STATUS_INDEX] = PAUSED;
-            } else {
-                 // Exit immediately from READY, PAUSED, FINISHED, or HISTORY views
-                 shm_ptr[STATUS_INDEX] = EXITING;
+        if (ch == '\n' || ch == KEY_ENTER || ch == 'v' || ch == 'V') {
+            // Open the selected race's track view
+            current_view = VIEW_TRACK;
+        } else if (ch == 'g' || ch == 'G' || ch == 'h' || ch == 'H') {
+            // Start/resume every race that is not running, or pause every running one
+            bool start = ch == 'g' || ch == 'G';
+            for (int race = 0; race < CONCURRENT_RACES; ++race) {
+                RaceShm* target = raceBlock(arena, race);
+                if (start) {
+                    if (startOrResumeRace(target)) result_logged[race] = false;
+                } else {
+                    changeRaceStatus(target, RUNNING, PAUSED);
+                }
             }
         }
+    } else { // Results, Stats or Analytics View
+        if (ch == 'b' || ch == 'B') {
+            // Switch back to the Race view (or the grid)
+            current_view = home_view;
+        }
+    }
+}
 
-        // --- View Specific Input Handling ---
+/**
+ * @brief Sleeps the monitor until the next frame is worth drawing (SYNC_EVENT mode).
+ *        If racers changed something since the frame at `drawn_seq`, it sleeps until
+ *        that frame is due (`next_frame_us`). Otherwise it blocks in poll() until a
+ *        racer wakes it, with no CPU use while races are ready, paused or finished.
+ *        Input, signals and stats subscribers always end the wait at once. `idle_ms`
+ *        bounds the blocking wait (-1 = none).
+ * @return true if the next frame must be drawn whatever the change counters say
+ *         (input, a signal or the idle timeout).
+ */
+static bool waitForMonitorEvent(RaceShm* arena, uint64_t drawn_seq, long next_frame_us, int idle_ms) {
+    struct pollfd fds[4];
+    fds[0].fd = STDIN_FILENO;
+    fds[0].events = POLLIN;
+    fds[1].fd = supervisor_fd; // Ignored by poll() while -1
+    fds[1].events = POLLIN;
+    fds[2].fd = stats_export_fd;
+    fds[2].events = POLLIN;
+    fds[3].fd = race_event_fd;
+    fds[3].events = POLLIN;
 
-        if (current_view == 0) { // Race/Control View
-            if (ch == 's' || ch == 'S') {
-                if (shm_ptr[STATUS_INDEX] == READY || shm_ptr[STATUS_INDEX] == FINISHED) {
-                    // Start new race: Fork processes
-                    start_race_processes(shmid);
-                    shm_ptr[STATUS_INDEX] = RUNNING;
+    // Subscriber traffic is served by the next pass but does not force a frame
+    if (raceChangeSeq(arena) != drawn_seq) {
+        long wait_us = next_frame_us - monotonic_us();
+        return wait_us > 0 && poll(fds, 3, (int)((wait_us + 999) / 1000)) > 0 &&
+               (fds[0].revents | fds[1].revents) != 0;
+    }
 
-                    // Record start time (use the long pointer)
-                    auto start_time = chrono::system_clock::now().time_since_epoch().count() / 1000000;
-                    *shm_long_ptr = start_time;
-                } else if (shm_ptr[STATUS_INDEX] == PAUSED) {
-                    // Resume race
-                    shm_ptr[STATUS_INDEX] = RUNNING;
-                }
-            } else if (ch == 'p' || ch == 'P') {
-                // Conditional Pause: only works when RUNNING
-                if (shm_ptr[STATUS_INDEX] == RUNNING) {
-                    shm_ptr[STATUS_INDEX] = PAUSED;
-                }
-            } else if (ch == 'r' || ch == 'R') {
-                 // Switch to Results view
-                current_view = 1;
-            }
-        } else { // Results View (current_view == 1)
-            if (ch == 'b' || ch == 'B') {
-                // Switch back to Race view
-                current_view = 0;
+    // Nothing new on screen: let the next racer change wake us. Re-checking after
+    // arming closes the race with a racer that bumped just before the flag was set.
+    if (armMonitorWakeup(arena) != drawn_seq) {
+        disarmMonitorWakeup(arena);
+        return false;
+    }
+    int ready = poll(fds, 4, idle_ms);
+    disarmMonitorWakeup(arena);
+    return ready == 0 || (fds[0].revents | fds[1].revents) != 0;
+}
+
+void runDisplayParent(RaceShm* shm) {
+    // One loop serves every race: all racers signal the same eventfd, and each pass
+    // logs whatever finished, in any view, before drawing the current one
+    vector<bool> result_logged(CONCURRENT_RACES, false); // The race's current result has been written
+    vector<int> winners(CONCURRENT_RACES, 0);
+    long races_completed = 0;
+    for (int race = 0; race < CONCURRENT_RACES; ++race) {
+        // Initialize start time to zero
+        raceBlock(shm, race)->start_time_ms = 0;
+    }
+
+    initNcurses();
+
+    int current_view = CONCURRENT_RACES > 1 ? VIEW_GRID : VIEW_TRACK;
+    int selected = 0; // Race shown by the track and stats views
+
+    // Main GUI Loop: frames are drawn when input arrives, or when racers bumped a change
+    // counter and the MAX_FPS interval has passed
+    long frame_interval_us = 1000000L / MAX_FPS;
+    long last_frame_us = 0;
+    uint64_t drawn_seq = raceChangeSeq(shm);
+    bool redraw = true; // Input, a signal or a view switch since the last frame
+    while (getRaceStatus(shm) != EXITING) {
+
+        // Reap crashed racers (DNF) and turn SIGINT/SIGTERM into a clean exit
+        if (handleSupervisorEvents(shm)) break;
+        serviceStatsExport(shm);
+
+        // Handle every pending key (non-blocking getch) before drawing. Keys that
+        // change the status are timed from the wakeup that delivered them.
+        long wake_us = monotonic_us();
+        int ch;
+        while ((ch = getch()) != ERR) {
+            redraw = true;
+            RaceShm* race = raceBlock(shm, selected);
+            int status_before = getRaceStatus(race);
+            handleMonitorKey(ch, shm, selected, current_view, result_logged);
+            if (getRaceStatus(race) != status_before) {
+                recordLatency(&raceStats(race)->hist[HIST_INPUT_TO_STATUS], race->status_changed_us - wake_us);
             }
         }
 
-        // --- Drawing Logic and Logging ---
+        drainRaceTrace(shm);
 
-        if (current_view == 0) {
-            int winner_id = 0;
-            // Get the start time from the long pointer
-            long start_time_ms = *shm_long_ptr;
+        // --- Logging: every race that finished since the last pass ---
+        bool logged = false;
+        for (int i = 0; i < CONCURRENT_RACES; ++i) {
+            RaceShm* race = raceBlock(shm, i);
+            if (getRaceStatus(race) != FINISHED || result_logged[i]) continue;
 
-            // Log result only once when race finishes (using start_time_ms != 1 as a log flag)
-            if (shm_ptr[STATUS_INDEX] == FINISHED && start_time_ms != 1) {
-                for (int i = 0; i < NUM_RACERS; ++i) {
-                    if (shm_ptr[POS_OFFSET + i] >= RACE_LENGTH) {
-                        winner_id = i + 1;
-                        break;
-                    }
-                }
+            // The finish order comes from the racers' atomic finish claims
+            RaceResult result = collectRaceResult(race);
+            winners[i] = result.winner;
+            logRaceResult(result);
+            publishStatsResult(i, result);
+            result_logged[i] = true;
+            races_completed++;
+            logged = true;
+        }
+        if (logged) {
+            flushResultsLog();
+        }
 
-                // Calculate duration and log
-                auto end_time = chrono::system_clock::now().time_since_epoch().count() / 1000000;
-                long duration_ms = end_time - start_time_ms;
+        // --- Drawing Logic: skipped while nothing changed, capped at MAX_FPS for racer steps ---
+        uint64_t seq = raceChangeSeq(shm);
+        long frame_start_us = monotonic_us();
+        bool frame_due = frame_start_us - last_frame_us >= frame_interval_us;
+        if (redraw || SYNC_MODE == SYNC_POLL || (seq != drawn_seq && frame_due)) {
+            // Subscribers get the frame too, whatever the view shows
+            if (seq != drawn_seq || redraw) publishStatsSnapshots(shm);
 
-                logRaceResult(winner_id, duration_ms);
-                // Set start time to 1 to indicate 'logged'
-                *shm_long_ptr = 1;
+            RaceShm* selected_race = raceBlock(shm, selected);
+            if (current_view == VIEW_TRACK) {
+                int winner_id = getRaceStatus(selected_race) == FINISHED ? winners[selected] : 0;
+                setTrackLane(selected);
+                drawRaceTrackGUI(selected_race, winner_id);
+            } else if (current_view == VIEW_RESULTS) {
+                drawResultsGUI();
+            } else if (current_view == VIEW_STATS) {
+                drawStatsGUI(selected_race);
+            } else if (current_view == VIEW_ANALYTICS) {
+                drawAnalyticsGUI();
+            } else {
+                drawRaceGridGUI(shm, selected, races_completed);
             }
+            recordLatency(&raceStats(selected_race)->hist[HIST_FRAME], monotonic_us() - frame_start_us);
+            last_frame_us = monotonic_us();
+            drawn_seq = seq;
+            redraw = false;
+        }
 
-            // Find winner ID for display, even if logged
-            if (shm_ptr[STATUS_INDEX] == FINISHED) {
-                for (int i = 0; i < NUM_RACERS; ++i) {
-                    if (shm_ptr[POS_OFFSET + i] >= RACE_LENGTH) {
-                        winner_id = i + 1;
-                        break;
-                    }
-                }
+        if (getRaceStatus(shm) == EXITING) {
+            // 'Q' was just handled: no racer may be left to wake the wait below
+            break;
+        } else if (SYNC_MODE == SYNC_EVENT) {
+            // Views of the results log also refresh now and then for other processes' results
+            int idle_ms = current_view == VIEW_RESULTS || current_view == VIEW_ANALYTICS ? IDLE_REFRESH_MS : -1;
+            redraw = waitForMonitorEvent(shm, drawn_seq, last_frame_us + frame_interval_us, idle_ms);
+        } else {
+            // Short delay for responsiveness
+            usleep(100000);
+        }
+    }
+
+    endNcurses();
+}
+
+// ----------------------------------------------------------------------
+// --- HEADLESS BATCH MODE ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief Waits (sliced) for progress in a running headless batch. A single race blocks
+ *        on its status futex; concurrent races (or a race serving --stats-socket) sleep
+ *        until a racer wakes the eventfd, unless one of the busy lanes already left
+ *        RUNNING. `slice_ms` bounds that sleep.
+ */
+void waitForRaceProgress(RaceShm* shm, const vector<bool>& lane_busy, int slice_ms) {
+    if (SYNC_MODE != SYNC_EVENT) {
+        usleep(1000);
+    } else if (race_event_fd == -1) {
+        // Shorter slices while recording, so the trace rings are drained in time
+        waitForStatusChange(shm, RUNNING, shm->trace_ring_size ? 5000 : 100000);
+    } else {
+        armMonitorWakeup(shm);
+        bool finished = false;
+        for (size_t lane = 0; lane < lane_busy.size(); ++lane) {
+            if (lane_busy[lane] && getRaceStatus(raceBlock(shm, (int)lane)) != RUNNING) finished = true;
+        }
+        if (!finished) {
+            struct pollfd fds[3];
+            fds[0].fd = race_event_fd;
+            fds[0].events = POLLIN;
+            fds[1].fd = supervisor_fd; // Ignored by poll() while -1
+            fds[1].events = POLLIN;
+            fds[2].fd = stats_export_fd;
+            fds[2].events = POLLIN;
+            poll(fds, 3, slice_ms);
+        }
+        disarmMonitorWakeup(shm);
+    }
+}
+
+/**
+ * @brief Runs HEADLESS_RACES races without ncurses and prints throughput (races/s,
+ *        steps/s) and the win distribution. With --concurrent M, up to M races run at
+ *        once and each lane starts its next race as soon as the previous one finishes.
+ */
+void runHeadless(RaceShm* shm) {
+    vector<long> wins(NUM_RACERS + 1, 0);
+    long total_steps = 0;
+    double start_us_total = 0; // Time spent creating/arming racers
+    int races_started = 0;
+    int races_run = 0;
+    uint64_t first_seed = 0;
+    int lanes = CONCURRENT_RACES < HEADLESS_RACES ? CONCURRENT_RACES : HEADLESS_RACES;
+    vector<bool> lane_busy(lanes, false);
+
+    cout << "Headless run: " << HEADLESS_RACES << " races, " << NUM_RACERS << " racers, length "
+         << RACE_LENGTH << ", delay scale " << DELAY_SCALE;
+    if (lanes > 1) cout << ", " << lanes << " at a time";
+    cout << "\n";
+
+    // Snapshots for --stats-socket subscribers go out at most MAX_FPS times a second
+    long export_interval_us = 1000000L / MAX_FPS;
+    long last_export_us = 0;
+    uint64_t exported_seq = raceChangeSeq(shm);
+
+    auto run_start = chrono::steady_clock::now();
+    bool aborted = false;
+    while (!aborted && races_run < HEADLESS_RACES) {
+        // Start a race on every idle lane while races remain
+        for (int lane = 0; lane < lanes && races_started < HEADLESS_RACES; ++lane) {
+            if (lane_busy[lane]) continue;
+            RaceShm* race = raceBlock(shm, lane);
+            auto start_begin = chrono::steady_clock::now();
+            start_race_processes(race);
+            start_us_total += chrono::duration<double, micro>(chrono::steady_clock::now() - start_begin).count();
+            if (races_started == 0) first_seed = race->race_seed;
+            race->start_time_ms = wall_clock_ms();
+            setRaceStatus(race, RUNNING);
+            lane_busy[lane] = true;
+            races_started++;
+        }
+
+        // Block until a racer closes a race (or the run is aborted). The wait is
+        // sliced so crashed racers are reaped and SIGINT/SIGTERM end the run.
+        // Changes not yet exported shorten the wait to the next export.
+        int slice_ms = 100;
+        if (stats_export_fd != -1 && raceChangeSeq(shm) != exported_seq) {
+            long until_export_us = last_export_us + export_interval_us - monotonic_us();
+            slice_ms = until_export_us > 0 ? (int)(until_export_us / 1000) + 1 : 0;
+        }
+        waitForRaceProgress(shm, lane_busy, slice_ms);
+        handleSupervisorEvents(shm);
+        drainRaceTrace(shm);
+
+        serviceStatsExport(shm);
+        uint64_t seq = raceChangeSeq(shm);
+        if (stats_export_fd != -1 && seq != exported_seq && monotonic_us() - last_export_us >= export_interval_us) {
+            publishStatsSnapshots(shm);
+            last_export_us = monotonic_us();
+            exported_seq = seq;
+        }
+
+        for (int lane = 0; lane < lanes; ++lane) {
+            if (!lane_busy[lane]) continue;
+            RaceShm* race = raceBlock(shm, lane);
+            int status = getRaceStatus(race);
+            if (status == RUNNING) continue;
+            if (status != FINISHED) {
+                aborted = true;
+                break;
             }
 
-            drawRaceTrackGUI(shm_ptr, winner_id, current_view);
-        } else {
-            drawResultsGUI();
+            RaceResult result = collectRaceResult(race);
+            wins[result.winner]++;
+            for (int steps : result.steps) {
+                total_steps += steps;
+            }
+            logRaceResult(result);
+            publishStatsResult(lane, result);
+            lane_busy[lane] = false;
+            races_run++;
         }
+    }
+    flushResultsLog();
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - run_start).count();
 
-        // Short delay for responsiveness
-        usleep(100000);
+    // Reap the last races' racers so their context switches are counted
+    for (int lane = 0; lane < lanes; ++lane) {
+        cleanup_children(raceBlock(shm, lane));
     }
+    struct rusage self_usage, child_usage;
+    getrusage(RUSAGE_SELF, &self_usage);
+    getrusage(RUSAGE_CHILDREN, &child_usage);
 
-    endNcurses();
+    printf("Elapsed: %.3f s | %.1f races/s | %.0f steps/s\n",
+           elapsed, races_run / elapsed, total_steps / elapsed);
+    printf("Backend: %s | avg race start: %.1f us | context switches: %ld voluntary, %ld involuntary\n",
+           RACE_BACKEND == BACKEND_THREAD ? "thread" : "fork",
+           races_started ? start_us_total / races_started : 0.0,
+           self_usage.ru_nvcsw + child_usage.ru_nvcsw, self_usage.ru_nivcsw + child_usage.ru_nivcsw);
+    printf("Seed: %llu (replay this batch with --seed)\n", (unsigned long long)first_seed);
+
+    // Win distribution, most wins first (top 20 for large fields)
+    vector<int> ranking;
+    for (int id = 1; id <= NUM_RACERS; ++id) ranking.push_back(id);
+    stable_sort(ranking.begin(), ranking.end(), [&wins](int a, int b) { return wins[a] > wins[b]; });
+    size_t shown = ranking.size() > 20 ? 20 : ranking.size();
 
-    if (shmdt(shm_ptr) == -1) {
-        perror("Monitor shmdt failed");
+    // With scheduling options the per-racer CPU share is the interesting part
+    bool show_cpu = schedulingConfigured();
+    cout << "Win distribution" << (shown < ranking.size() ? " (top 20)" : "") << ":\n";
+    for (size_t i = 0; i < shown; ++i) {
+        int id = ranking[i];
+        printf("  Racer %-5d %8ld  (%5.1f%%)", id, wins[id], races_run ? 100.0 * wins[id] / races_run : 0.0);
+        if (show_cpu) {
+            // Racer id's CPU time and migrations, summed over every lane
+            long cpu_us = 0;
+            int migrations = 0;
+            for (int lane = 0; lane < lanes; ++lane) {
+                RacerSlot* slot = racerSlot(raceBlock(shm, lane), id - 1);
+                cpu_us += slot->cpu_us;
+                migrations += slot->migrations;
+            }
+            printf("  cpu %9.1f ms  %5d migrations", cpu_us / 1000.0, migrations);
+        }
+        printf("\n");
     }
 }
 
@@ -240,6 +1122,46 @@ void runDisplayParent(int shmid) {
 // --- CLEANUP ---
 // ----------------------------------------------------------------------
 
+/**
+ * @brief Attaches the race segment and checks its layout version.
+ * @return nullptr (errno set) if the attach fails or the segment has a different layout.
+ */
+RaceShm* attachRaceShm(int shmid) {
+    void* addr = shmat(shmid, nullptr, 0);
+    if (addr == (void*)-1) {
+        return nullptr;
+    }
+
+    RaceShm* shm = (RaceShm*)addr;
+    if (shm->magic != RACE_SHM_MAGIC || shm->version != RACE_SHM_VERSION || shm->num_racers != NUM_RACERS) {
+        shmdt(addr);
+        errno = EPROTO;
+        return nullptr;
+    }
+    return shm;
+}
+
+void detachRaceShm(RaceShm* shm) {
+    if (shmdt(shm) == -1) {
+        perror("shmdt failed");
+    }
+}
+
+/**
+ * @brief Writes the versioned header of a freshly created (zero-filled) segment.
+ */
+void initRaceShm(RaceShm* shm) {
+    shm->magic = RACE_SHM_MAGIC;
+    shm->version = RACE_SHM_VERSION;
+    shm->num_racers = NUM_RACERS;
+    shm->race_length = RACE_LENGTH;
+    shm->status = READY;
+    shm->finish_count = 0;
+    shm->start_time_ms = 0;
+    shm->race_seed = 0;
+    shm->trace_ring_size = RECORD_PATH.empty() ? 0 : TRACE_RING_SIZE;
+}
+
 void cleanup_shm(int shmid) {
     if (shmctl(shmid, IPC_RMID, nullptr) == -1) {
         perror("shmctl (IPC_RMID) failed");
@@ -3,11 +3,21 @@
 
 #include <sys/types.h>
 #include <cstdlib>
+#include <cstdint>
+#include <vector>
+#include <string>
 #include <unistd.h> // Include for usleep, often needed in logic files
+#include "RaceStats.h"
 
-// --- Configuration Constants (Declarations Only) ---
-extern const int RACE_LENGTH;
-extern const int NUM_RACERS;
+// --- Configuration (Declarations Only) ---
+// Defined in RaceConfig.cpp and set once at startup by configureRace(),
+// before the shared memory segment is created or any racer is forked.
+extern int RACE_LENGTH;
+extern int NUM_RACERS;
+
+// Upper bounds accepted from the command line / config file
+const int MAX_RACERS = 10000;
+const int MAX_RACE_LENGTH = 1000000;
 
 // Enums for Race Status (Stored in Shared Memory)
 enum RaceStatus {
@@ -18,22 +28,419 @@ enum RaceStatus {
     EXITING = 4
 };
 
+// How racers and the monitor wait for each other
+enum RaceSyncMode {
+    SYNC_EVENT = 0, // Futex on the status word + eventfd to the monitor (default)
+    SYNC_POLL = 1   // Original usleep polling loops
+};
+extern int SYNC_MODE;
+
+// Redraw cap of the monitor in SYNC_EVENT mode (--max-fps). Frames are only drawn
+// when a racer bumped a change counter, a key was pressed or a signal arrived.
+extern int MAX_FPS;
+const int MAX_MAX_FPS = 1000;
+
+// eventfd racers write to when they wake a blocked monitor (SYNC_EVENT only, -1 otherwise)
+extern int race_event_fd;
+
+// Number of finishers that ends the race (1 = first across the line, 0 = all racers)
+extern int PODIUM_SIZE;
+
+// Independent races supervised by one monitor (--concurrent M). Each race has its own
+// block in the arena (see raceBlock) and its own set of racers.
+extern int CONCURRENT_RACES;
+const int MAX_CONCURRENT_RACES = 1024;
+
+// --- Headless batch mode (see runHeadless) ---
+extern bool HEADLESS;        // Run races back-to-back without ncurses
+extern int HEADLESS_RACES;   // Number of races in a headless run
+extern double DELAY_SCALE;   // Multiplier for the per-step delay (0 = no sleeps)
+extern bool LOG_RESULTS;     // Log each result to race_results.rlog, race_results.txt and race_results.stats
+
+// --- Tournaments (see RaceTournament.cpp) ---
+extern int TOURNAMENT_ENTRANTS; // --tournament N: run an elimination tournament of N entrants (0 = off)
+const int MAX_TOURNAMENT_ENTRANTS = 1000000;
+
+// --- Latency instrumentation (see RaceStats.h) ---
+extern std::string STATS_OUT; // Write the latency stats as JSON here on exit ("" = don't)
+extern std::string STATS_SOCKET; // --stats-socket PATH: stream live snapshots and results ("" = off)
+
+// --- Monte Carlo simulation (see RaceSimulation.cpp) ---
+extern int SIMULATE_RACES;   // > 0: simulate this many races in-process and exit
+
+// --- Race traces (see RaceTrace.cpp) ---
+extern std::string RECORD_PATH; // --record FILE: write every racer step to FILE ("" = off)
+extern std::string REPLAY_PATH; // --replay FILE: replay FILE instead of racing
+extern double REPLAY_SPEED;     // --speed X: replay speed multiplier (default 1)
+
+// --- Race seeds (see RaceRng.h) ---
+extern uint64_t RACE_SEED;   // Seed of the first race; later races use nextSeed()
+extern bool RACE_SEED_SET;   // false: the first seed is picked at random
+
+// --- Racer scheduling (see RaceScheduling.cpp) ---
+enum RacerStepMode {
+    STEP_SLEEP = 0, // The per-step delay is slept (default)
+    STEP_WORK = 1   // The per-step delay is burned as CPU time, so racers compete for cores
+};
+extern int STEP_MODE;
+enum RacerPinMode {
+    PIN_NONE = 0,   // Racers inherit the monitor's affinity (default)
+    PIN_SPREAD = 1  // Racer i is pinned to the i-th allowed CPU, round robin
+};
+extern int PIN_MODE;
+
+// RacerSlot::sched_failed bits: settings the kernel refused for that racer
+const uint16_t SCHED_FAILED_AFFINITY = 1;
+const uint16_t SCHED_FAILED_POLICY = 2;
+const uint16_t SCHED_FAILED_NICE = 4;
+
+// How racers are executed (see RaceBackend.cpp)
+enum RaceBackendKind {
+    BACKEND_FORK = 0,  // One forked process per racer, SysV shared memory (default)
+    BACKEND_THREAD = 1 // Pool of racer threads over an in-process arena
+};
+extern int RACE_BACKEND;
+extern bool PREFORK;         // Fork backend: fork a racer pool once and reuse it across races
+
+// Where the fork backend's shared segment comes from
+enum ShmKind {
+    SHM_SYSV = 0,  // shmget/shmat; every forked racer attaches by ID (default)
+    SHM_POSIX = 1, // shm_open + mmap, unlinked right away; inherited across fork
+    SHM_MEMFD = 2  // memfd_create + mmap (optionally huge pages); inherited across fork
+};
+extern int SHM_KIND;
+extern bool HUGE_PAGES;      // SHM_MEMFD: back the segment with huge pages if available
+
+// SysV segment ID of the fork backend (-1 for the thread backend and non-SysV segments)
+extern int race_shmid;
+
 // --- Shared Memory Structure ---
-// SHM_SIZE: Defined in RaceLogic.cpp, declared here.
-extern const size_t SHM_SIZE;
+// The segment is a RaceShm header (one read-mostly control block) followed by
+// NUM_RACERS cache-line-aligned RacerSlots, the finish-order array and the
+// latency histograms:
+//
+//   [ RaceShm | RacerSlot 0 | RacerSlot 1 | ... | RacerSlot N-1 | finish_order[N] | RaceStats | trace rings ]
+//
+// The trace rings (one per racer) only exist while recording (--record).
+// With --concurrent M the arena holds M such blocks back to back, each
+// RACE_BLOCK_SIZE bytes (a multiple of the cache line), one per race.
+//
+// Each racer only writes its own slot, so a position update no longer
+// invalidates the line every other racer and the monitor are reading. The
+// control block is written only on state changes (start/pause/finish); the
+// racers' change counter lives on the header's second line so that bumping it
+// never invalidates the status word every racer polls.
+// Bump RACE_SHM_VERSION whenever this layout changes.
+
+const size_t CACHE_LINE_SIZE = 64;
+const uint32_t RACE_SHM_MAGIC = 0x52414345; // "RACE"
+const uint32_t RACE_SHM_VERSION = 10;
+
+struct alignas(CACHE_LINE_SIZE) RaceShm {
+    uint32_t magic;       // RACE_SHM_MAGIC
+    uint32_t version;     // RACE_SHM_VERSION
+    int num_racers;       // Layout parameters, fixed when the segment is created
+    int race_length;
+    int status;           // RaceStatus; also the futex racers sleep on
+    int finish_count;     // Atomic finish-order counter
+    long start_time_ms;   // Race start, ms since epoch
+    int generation;       // Bumped to start pooled racers on a new race (futex)
+    int active_workers;   // Pooled racers still in the current race (futex)
+    uint64_t race_seed;   // Seed of the current race's racer streams
+    long status_changed_us; // monotonic_us() of the last setRaceStatus()
+    int dnf_count;        // Racers that died during the current race
+    int trace_ring_size;  // Events per racer trace ring (0 = not recording, see --record)
+
+    // Racer -> monitor change signalling (see notifyMonitor)
+    alignas(CACHE_LINE_SIZE) uint32_t change_seq; // Bumped by racers on every step and finish
+    int monitor_waiting;  // 1 while the monitor is blocked: the next bump writes the eventfd
+};
+
+struct alignas(CACHE_LINE_SIZE) RacerSlot {
+    int position;         // Written only by the owning racer
+    int pid;
+    long finish_time_ms;  // 0 until the racer crosses the line
+    int steps;            // Steps taken in the current race
+    int races_served;     // Races this pooled racer has run (never reset)
+    long last_step_us;    // monotonic_us() of the latest step (0 before the first)
+    long paused_us;       // Total time spent paused, over all races
+    uint32_t seq;         // Seqlock over position, pid, steps, last_step_us, finish_time_ms
+    uint16_t dnf;         // 1 if the racer died during the current race (set by the monitor)
+    uint16_t worker_active; // Pooled racer is inside the current race (see armWorkers)
+    long cpu_us;          // CPU time used while racing, over all races
+    int migrations;       // Times a step ran on a different CPU than the previous one
+    int16_t cpu;          // CPU of the latest step (-1 before the first)
+    uint16_t sched_failed; // SCHED_FAILED_* bits (see applyRacerScheduling)
+};
+
+static_assert(sizeof(RaceShm) == 2 * CACHE_LINE_SIZE, "RaceShm: one control line plus the change counter line");
+static_assert(sizeof(RacerSlot) == CACHE_LINE_SIZE, "RacerSlot must fill one cache line");
+
+inline RacerSlot* racerSlot(RaceShm* shm, int index) {
+    return reinterpret_cast<RacerSlot*>(shm + 1) + index;
+}
+
+// --- Racer slot seqlock ---
+// A slot's position, pid, steps, last_step_us and finish_time_ms change together.
+// Their one writer (the owning racer; the monitor only between races) brackets
+// the stores with these two calls, which keep RacerSlot::seq odd while a write is
+// in flight: two plain stores and a fence, never a lock. Readers copy slots with
+// takeRaceSnapshot() (RaceLogic.cpp) and retry around writes.
+inline void racerSlotWriteBegin(RacerSlot* slot) {
+    __atomic_store_n(&slot->seq, __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+inline void racerSlotWriteEnd(RacerSlot* slot) {
+    __atomic_store_n(&slot->seq, __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE);
+}
 
-// --- Shared Memory Index Definitions (Declarations) ---
-// These indices must be defined in RaceLogic.cpp, but declared here for use in main.cpp and RaceLogic.cpp
-extern const int POS_OFFSET;       // Start of racer positions (0)
-extern const int PID_OFFSET;       // Start of racer PIDs (NUM_RACERS)
-extern const int STATUS_INDEX;     // Index for RaceStatus enum (NUM_RACERS * 2)
-extern const int START_TIME_INDEX; // Index for race start time (STATUS_INDEX + 1)
+// Racer ids by finishing place (winner first), 0 until claimed
+inline int* finishOrder(RaceShm* shm) {
+    return reinterpret_cast<int*>(racerSlot(shm, shm->num_racers));
+}
+
+inline size_t raceStatsOffset(int num_racers) {
+    size_t end = sizeof(RaceShm) + sizeof(RacerSlot) * num_racers + sizeof(int) * num_racers;
+    return (end + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
+inline RaceStats* raceStats(RaceShm* shm) {
+    return reinterpret_cast<RaceStats*>(reinterpret_cast<char*>(shm) + raceStatsOffset(shm->num_racers));
+}
+
+// --- Trace rings (--record) ---
+// Single-producer/single-consumer ring per racer: the racer appends one event per
+// step (plain stores, no syscall), the monitor drains them into the trace file.
+const int TRACE_RING_SIZE = 256; // Events per ring (power of two)
+
+struct TraceEvent {
+    long t_us;            // monotonic_us() of the step
+    int position;         // Position after the step
+    int reserved;
+};
+
+struct alignas(CACHE_LINE_SIZE) TraceRing {
+    uint32_t head;        // Next event the racer writes (racer only)
+    uint32_t dropped;     // Events lost because the ring was full (racer only)
+    alignas(CACHE_LINE_SIZE) uint32_t tail; // Next event the monitor reads (monitor only)
+    // Followed by trace_ring_size TraceEvents
+};
+
+inline size_t traceRingStride(int ring_size) {
+    return sizeof(TraceRing) + sizeof(TraceEvent) * ring_size;
+}
+
+inline TraceRing* traceRing(RaceShm* shm, int index) {
+    char* rings = reinterpret_cast<char*>(raceStats(shm)) + sizeof(RaceStats);
+    return reinterpret_cast<TraceRing*>(rings + traceRingStride(shm->trace_ring_size) * index);
+}
+
+inline TraceEvent* traceEvents(TraceRing* ring) {
+    return reinterpret_cast<TraceEvent*>(ring + 1);
+}
+
+inline size_t raceShmSize(int num_racers, int trace_ring_size = 0) {
+    size_t rings = trace_ring_size > 0 ? traceRingStride(trace_ring_size) * num_racers : 0;
+    return raceStatsOffset(num_racers) + sizeof(RaceStats) + rings;
+}
+
+// RACE_BLOCK_SIZE: raceShmSize(NUM_RACERS) rounded up to a cache line;
+// SHM_SIZE: the whole arena, CONCURRENT_RACES blocks. Computed in RaceConfig.cpp
+extern size_t RACE_BLOCK_SIZE;
+extern size_t SHM_SIZE;
+
+// Race `index` of the arena whose first block is `arena`
+inline RaceShm* raceBlock(RaceShm* arena, int index) {
+    return reinterpret_cast<RaceShm*>(reinterpret_cast<char*>(arena) + RACE_BLOCK_SIZE * index);
+}
+
+inline int raceBlockIndex(RaceShm* arena, RaceShm* race) {
+    return (int)((reinterpret_cast<char*>(race) - reinterpret_cast<char*>(arena)) / RACE_BLOCK_SIZE);
+}
+
+// --- Race Results (ResultsStore.cpp) ---
+struct RaceResult {
+    long timestamp;                 // Unix time the result was logged
+    long start_time_ms;             // Race start, ms since epoch
+    long duration_ms;               // Winner's time
+    int winner;
+    uint64_t seed;                  // Race seed (0 for results imported from the text log)
+    std::vector<int> finish_order;  // Racer ids, winner first
+    std::vector<long> finish_ms;    // Finish time relative to the start, per finish_order entry
+    std::vector<int> steps;         // Steps taken, per racer (racer id - 1)
+};
+
+// --- Race snapshots (takeRaceSnapshot in RaceLogic.cpp) ---
+// One race as it was at a single instant: every racer copied through its slot
+// seqlock, and the copy validated against the status and finish counters.
+struct RacerSnapshot {
+    int position;
+    int pid;
+    int steps;
+    int dnf;
+    long finish_time_ms;  // 0 until the racer crossed the line
+    long last_step_us;
+};
+
+struct RaceSnapshot {
+    int status;
+    int finish_count;
+    int dnf_count;
+    uint64_t race_seed;
+    long start_time_ms;
+    bool consistent;                    // false: retries ran out, racers are copied one by one
+    std::vector<RacerSnapshot> racers;  // By racer id - 1
+    std::vector<int> finish_order;      // Racer ids, winner first (finish_count entries)
+};
+
+// Whole-log aggregates, stored in every record footer of race_results.rlog
+struct ResultsAggregate {
+    int64_t total_races;
+    int64_t total_duration_ms;
+    int64_t min_duration_ms;
+    int64_t max_duration_ms;
+    int64_t timed_races;     // Races with a winner (count of the duration aggregates)
+};
+
+// Whole-history statistics (ResultsAnalytics.cpp): kept current as results are
+// logged and saved next to the log, so they never require a rescan of it
+struct RacerAnalytics {
+    int racer_id;
+    int64_t starts;          // Races this racer was entered in
+    int64_t wins;
+    int64_t podiums;         // Top-three finishes
+    int64_t current_streak;  // Consecutive wins up to the latest race
+    int64_t best_streak;
+    int64_t finishes;        // Races this racer crossed the line in
+    double finish_mean_ms;   // Mean / standard deviation of its finish times
+    double finish_sd_ms;
+};
+
+struct ResultsAnalytics {
+    uint64_t version = 0;     // Change counter of the state this was taken from
+    size_t racer_limit = 0;
+    int64_t races = 0;
+    int64_t timed_races = 0;  // Races with a winner; the winning time figures cover these
+    double mean_ms = 0, sd_ms = 0;
+    int64_t min_ms = 0, max_ms = 0;
+    double p50_ms = 0, p90_ms = 0, p95_ms = 0, p99_ms = 0; // Within 1% (quantile sketch)
+    int streak_racer = 0;     // Winner of the latest race, and its current streak
+    int64_t streak = 0;
+    int best_streak_racer = 0; // Longest winning streak on record
+    int64_t best_streak = 0;
+    int64_t caught_up = 0;    // Records folded in from the log by the last load
+    bool rebuilt = false;     // The last load rebuilt race_results.stats from the whole log
+    std::vector<RacerAnalytics> racers; // Most wins first, at most racer_limit entries
+};
+
+extern int RESULTS_TAIL; // --results-tail N: print the last N results and exit
+extern bool RESULTS_ANALYTICS; // --analytics: print the whole-history analytics and exit
 
 // --- Function Prototypes ---
-void runRacer(int racer_id, int shmid);
-void runDisplayParent(int shmid);
+enum ConfigResult {
+    CONFIG_RUN = 0,   // Options are valid: go on and run
+    CONFIG_EXIT = 1,  // Nothing to run, not an error (--help): exit with status 0
+    CONFIG_ERROR = 2  // Bad option (already reported): exit with status 1
+};
+ConfigResult configureRace(int argc, char* argv[]);
+void computeShmLayout();
+void runRacer(int racer_id, RaceShm* shm);
+void runDisplayParent(RaceShm* shm);
+void runHeadless(RaceShm* shm);
+void waitForRaceProgress(RaceShm* shm, const std::vector<bool>& lane_busy, int slice_ms);
+void runTournament(RaceShm* shm);
+void runSimulation();
+bool writeRaceStatsJson(RaceShm* shm, const std::string& path);
 void cleanup_shm(int shmid);
-void logRaceResult(int winner_id, long duration_ms);
-void start_race_processes(int shmid);
+RaceShm* attachRaceShm(int shmid);
+void detachRaceShm(RaceShm* shm);
+void initRaceShm(RaceShm* shm);
+
+// Results log (ResultsStore.cpp)
+extern const char* RESULTS_LOG_FILE; // race_results.rlog
+bool openResultsLog();
+void flushResultsLog();
+void closeResultsLog();
+void logRaceResult(const RaceResult& result);
+bool loadRecentResults(size_t count, std::vector<RaceResult>& out);
+bool loadResultsAggregate(ResultsAggregate& totals);
+std::string formatResultLine(const RaceResult& result);
+void printResultsTail(size_t count);
+void recentResultLines(size_t count, std::vector<std::string>& out);
+int64_t resultsLogRacesAt(off_t end);
+off_t readResultsFrom(off_t offset, void (*visit)(const RaceResult&));
+
+// Results analytics (ResultsAnalytics.cpp)
+bool syncResultsAnalytics();
+void foldIntoResultsAnalytics(const RaceResult& result);
+void resultsAnalyticsFlushed(off_t before, off_t after);
+bool resultsAnalyticsSnapshot(ResultsAnalytics& out, size_t max_racers);
+void printResultsAnalytics();
+
+
+// Racer backends (RaceBackend.cpp)
+RaceShm* createRaceArena();
+std::string describeRaceArena();
+void destroyRaceArena(RaceShm* shm);
+void start_race_processes(RaceShm* shm);
+void cleanup_children(RaceShm* shm);
+void shutdownRacers(RaceShm* shm);
+bool startRacerPool(RaceShm* shm);
+void printRacerPoolReport(RaceShm* shm);
+size_t activeRacerCount();
+void reapRacers();
+
+// Race traces (RaceTrace.cpp)
+bool openTraceRecorder(const std::string& path);
+void drainRaceTrace(RaceShm* shm);
+void closeTraceRecorder(RaceShm* shm);
+int runReplay();
+
+// Racer scheduling (RaceScheduling.cpp)
+bool applySchedulingSetting(const std::string& key, const std::string& value);
+bool finishSchedulingConfig();
+bool schedulingConfigured();
+void applyRacerScheduling(RaceShm* shm, int racer_id);
+std::string describeRacerScheduling();
+void printSchedulingReport(RaceShm* shm);
+
+// Racer profiles (RaceProfiles.cpp; tables and samplers in RaceProfiles.h)
+struct RacerProfile;
+bool applyProfileSetting(const std::string& key, const std::string& value);
+bool finishProfileConfig();
+bool profilesConfigured();
+const RacerProfile* racerProfile(int racer_id);
+std::string describeRacerProfiles();
+
+// Live stats export (RaceExport.cpp): line-delimited JSON over a Unix socket
+extern int stats_export_fd;   // epoll set of the listener and subscribers (-1 if off)
+bool openStatsExport(const std::string& path);
+void serviceStatsExport(RaceShm* arena);
+void publishStatsSnapshots(RaceShm* arena);
+void publishStatsResult(int race, const RaceResult& result);
+void dropStatsExport();
+void closeStatsExport();
+
+// Supervisor (RaceSupervisor.cpp): signals, racer deaths, stale segments
+extern int supervisor_fd;     // signalfd for SIGCHLD/SIGINT/SIGTERM/SIGHUP (-1 if not set up)
+bool initSupervisor();
+void closeSupervisor();
+bool handleSupervisorEvents(RaceShm* shm);
+void prepareRacerChild();
+int removeStaleSegments();
+
+// Status access: always go through these so futex waiters are woken
+int getRaceStatus(RaceShm* shm);
+void setRaceStatus(RaceShm* shm, int status);
+bool initRaceEvents();
+void closeRaceEvents();
+void notifyMonitor(RaceShm* shm);
+
+// Finish bookkeeping (lock-free, see RaceLogic.cpp)
+bool takeRaceSnapshot(RaceShm* shm, RaceSnapshot& snap);
+void resetRaceState(RaceShm* shm);
+void markRacerDnf(RaceShm* shm, int racer_id);
+RaceResult collectRaceResult(RaceShm* shm);
 
 #endif // RACELOGIC_H
\ No newline at end of file
@@ -0,0 +1,369 @@
+#include "RaceLogic.h"
+#include "RaceProfiles.h"
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+
+using namespace std;
+
+// ----------------------------------------------------------------------
+// --- RACER PROFILES ---
+// ----------------------------------------------------------------------
+
+// Heterogeneous racers, from the CLI or the config file:
+//   profile.NAME.steps   = 1-4  |  1:5,2:3,3:1,4:1    step sizes (uniform range or size:weight)
+//   profile.NAME.delay   = uniform:250-400 | fixed:300 | normal:300,40 | lognormal:300,0.25
+//                          | exp:MEAN[,MIN]           delay after each step, in ms
+//   profile.NAME.burst   = P,SCALE[,LENGTH]            windows of LENGTH steps (default 1) are
+//                                                      bursts with probability P; a burst's
+//                                                      delays are multiplied by SCALE
+//   profile.NAME.fatigue = AMOUNT[,FROM[,linear|quadratic]]
+//                                                      delays grow to (1 + AMOUNT)x at the
+//                                                      finish, starting at track fraction FROM
+//   racer.N.profile      = NAME   (racer.*.profile or --profile NAME for every racer)
+// Unset parts of a profile keep the built-in behaviour (steps 1-4, 250-400 ms).
+// Racers without a profile use the built-in draw unchanged, so seeds logged before
+// profiles existed still replay. finishProfileConfig() builds the tables of
+// RaceProfiles.h once; racers only read them.
+
+struct ProfileSpec {
+    vector<pair<int, double>> steps = {{1, 1.0}, {2, 1.0}, {3, 1.0}, {4, 1.0}};
+    string delay_kind = "uniform";
+    double delay_a = 250.0, delay_b = 400.0; // Parameters of delay_kind, in ms
+    double burst_p = 0.0, burst_scale = 1.0;
+    int burst_length = 1;
+    double fatigue = 0.0, fatigue_from = 0.0;
+    bool fatigue_quadratic = false;
+};
+
+static map<string, ProfileSpec> profile_specs;
+static map<int, string> racer_profile_names; // Racer id (0 = '*') -> profile name
+
+// Built by finishProfileConfig(): one table set per used profile, shared by its racers
+static vector<RacerProfile> profiles;
+static vector<string> profile_names;
+static vector<int> racer_profile_index; // Per racer id, -1 = built-in draw
+
+static vector<string> splitList(const string& value) {
+    vector<string> items;
+    size_t pos = 0;
+    while (true) {
+        size_t comma = value.find(',', pos);
+        items.push_back(value.substr(pos, comma == string::npos ? string::npos : comma - pos));
+        if (comma == string::npos) break;
+        pos = comma + 1;
+    }
+    return items;
+}
+
+static bool parseNumber(const string& text, double& out) {
+    char* end = nullptr;
+    out = strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0' && std::isfinite(out);
+}
+
+static bool parseSteps(const string& key, const string& value, ProfileSpec& spec) {
+    vector<pair<int, double>> steps;
+    char* end = nullptr;
+    long first = strtol(value.c_str(), &end, 10);
+    if (*end == '-') {
+        // "1-4": uniform over a range
+        long last = strtol(end + 1, &end, 10);
+        if (*end == '\0' && first >= 1 && last >= first && last <= PROFILE_MAX_STEP) {
+            for (long step = first; step <= last; ++step) steps.push_back({(int)step, 1.0});
+        }
+    } else {
+        // "1:5,2:3": step size and weight
+        for (const string& item : splitList(value)) {
+            size_t colon = item.find(':');
+            double size, weight;
+            if (colon == string::npos || !parseNumber(item.substr(0, colon), size) ||
+                !parseNumber(item.substr(colon + 1), weight) || size != floor(size) || size < 1 ||
+                size > PROFILE_MAX_STEP || weight < 0) {
+                steps.clear();
+                break;
+            }
+            steps.push_back({(int)size, weight});
+        }
+    }
+
+    double total = 0;
+    for (auto& step : steps) total += step.second;
+    if (steps.empty() || steps.size() > (size_t)PROFILE_MAX_STEP || total <= 0) {
+        cerr << "Error: " << key << " must be a range like '1-4' or 'size:weight' pairs like '1:5,2:3,4:1'"
+             << " (sizes 1-" << PROFILE_MAX_STEP << "), got '" << value << "'." << endl;
+        return false;
+    }
+    spec.steps = steps;
+    return true;
+}
+
+static bool parseDelay(const string& key, const string& value, ProfileSpec& spec) {
+    size_t colon = value.find(':');
+    string kind = value.substr(0, colon);
+    string args = colon == string::npos ? "" : value.substr(colon + 1);
+
+    double a = 0, b = 0;
+    bool ok = false;
+    if (kind == "uniform") {
+        size_t dash = args.find('-');
+        ok = dash != string::npos && parseNumber(args.substr(0, dash), a) &&
+             parseNumber(args.substr(dash + 1), b) && a >= 0 && b >= a;
+    } else if (kind == "fixed") {
+        ok = parseNumber(args, a) && a >= 0;
+        b = a;
+    } else {
+        vector<string> items = splitList(args);
+        ok = !items.empty() && items.size() <= 2 && parseNumber(items[0], a) && a > 0 &&
+             (items.size() == 1 || parseNumber(items[1], b)) && b >= 0;
+        if (kind == "normal" || kind == "lognormal") ok = ok && items.size() == 2;
+        else if (kind != "exp") ok = false;
+    }
+    if (!ok) {
+        cerr << "Error: " << key << " must be uniform:MIN-MAX, fixed:MS, normal:MEAN,SD, lognormal:MEDIAN,SIGMA"
+             << " or exp:MEAN[,MIN] (milliseconds), got '" << value << "'." << endl;
+        return false;
+    }
+    spec.delay_kind = kind;
+    spec.delay_a = a;
+    spec.delay_b = b;
+    return true;
+}
+
+static bool parseBurst(const string& key, const string& value, ProfileSpec& spec) {
+    vector<string> items = splitList(value);
+    double p, scale, length = 1;
+    if (items.size() < 2 || items.size() > 3 || !parseNumber(items[0], p) || !parseNumber(items[1], scale) ||
+        (items.size() == 3 && !parseNumber(items[2], length)) || p < 0 || p > 1 || scale < 0 || scale > 1000 ||
+        length < 1 || length > 1000000 || length != floor(length)) {
+        cerr << "Error: " << key << " must be P,SCALE[,LENGTH] (P in [0, 1], SCALE in [0, 1000], LENGTH steps),"
+             << " got '" << value << "'." << endl;
+        return false;
+    }
+    spec.burst_p = p;
+    spec.burst_scale = scale;
+    spec.burst_length = (int)length;
+    return true;
+}
+
+static bool parseFatigue(const string& key, const string& value, ProfileSpec& spec) {
+    vector<string> items = splitList(value);
+    double amount, from = 0;
+    bool quadratic = false;
+    bool ok = items.size() <= 3 && parseNumber(items[0], amount) && amount > -1 && amount <= 1000 &&
+              (items.size() < 2 || (parseNumber(items[1], from) && from >= 0 && from < 1));
+    if (ok && items.size() == 3) {
+        if (items[2] == "quadratic") quadratic = true;
+        else ok = items[2] == "linear";
+    }
+    if (!ok) {
+        cerr << "Error: " << key << " must be AMOUNT[,FROM[,linear|quadratic]] (AMOUNT > -1, FROM in [0, 1)),"
+             << " got '" << value << "'." << endl;
+        return false;
+    }
+    spec.fatigue = amount;
+    spec.fatigue_from = from;
+    spec.fatigue_quadratic = quadratic;
+    return true;
+}
+
+/**
+ * @brief Applies a profile setting: profile.NAME.{steps,delay,burst,fatigue},
+ *        racer.<id|*>.profile or profile (= racer.*.profile).
+ */
+bool applyProfileSetting(const string& key, const string& value) {
+    if (key == "profile" || key.rfind("racer.", 0) == 0) {
+        int racer_id = 0;
+        if (key != "profile") {
+            string id = key.substr(6, key.size() - 6 - string(".profile").size());
+            char* end = nullptr;
+            long parsed = strtol(id.c_str(), &end, 10);
+            if (id != "*" && (id.empty() || *end != '\0' || parsed < 1 || parsed > MAX_RACERS)) {
+                cerr << "Error: expected 'racer.<id>.profile' or 'racer.*.profile', got '" << key << "'." << endl;
+                return false;
+            }
+            racer_id = id == "*" ? 0 : (int)parsed;
+        }
+        if (value.empty()) {
+            cerr << "Error: " << key << " needs a profile name." << endl;
+            return false;
+        }
+        racer_profile_names[racer_id] = value;
+        return true;
+    }
+
+    // profile.NAME.setting (NAME may not contain dots)
+    size_t dot = key.find('.', 8);
+    string name = dot == string::npos ? "" : key.substr(8, dot - 8);
+    string setting = dot == string::npos ? "" : key.substr(dot + 1);
+    if (name.empty() || setting.find('.') != string::npos) {
+        cerr << "Error: expected 'profile.<name>.<setting>', got '" << key << "'." << endl;
+        return false;
+    }
+
+    ProfileSpec& spec = profile_specs[name];
+    if (setting == "steps") return parseSteps(key, value, spec);
+    if (setting == "delay") return parseDelay(key, value, spec);
+    if (setting == "burst") return parseBurst(key, value, spec);
+    if (setting == "fatigue") return parseFatigue(key, value, spec);
+    cerr << "Error: Unknown profile setting '" << setting << "' (steps, delay, burst, fatigue)." << endl;
+    return false;
+}
+
+/**
+ * @brief Standard normal quantile, by bisection on erfc (only used to build tables).
+ */
+static double normalQuantile(double u) {
+    double low = -10.0, high = 10.0;
+    for (int i = 0; i < 100; ++i) {
+        double mid = (low + high) / 2;
+        if (0.5 * erfc(-mid / sqrt(2.0)) < u) low = mid;
+        else high = mid;
+    }
+    return (low + high) / 2;
+}
+
+static double delayQuantileMs(const ProfileSpec& spec, double u) {
+    if (spec.delay_kind == "uniform" || spec.delay_kind == "fixed") {
+        return spec.delay_a + (spec.delay_b - spec.delay_a) * u;
+    } else if (spec.delay_kind == "normal") {
+        return max(0.0, spec.delay_a + spec.delay_b * normalQuantile(u));
+    } else if (spec.delay_kind == "lognormal") {
+        return spec.delay_a * exp(spec.delay_b * normalQuantile(u));
+    }
+    return spec.delay_b + spec.delay_a * -log(1.0 - u); // exp: MIN + exponential(MEAN)
+}
+
+/**
+ * @brief Vose's alias method: every column holds at most two step sizes, picked by a
+ *        16-bit coin.
+ */
+static void buildStepAlias(const ProfileSpec& spec, RacerProfile& p) {
+    int n = (int)spec.steps.size();
+    double total = 0;
+    for (auto& step : spec.steps) total += step.second;
+
+    vector<double> scaled(n);
+    vector<int> small, large;
+    for (int i = 0; i < n; ++i) {
+        scaled[i] = spec.steps[i].second * n / total;
+        (scaled[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    p.step_columns = n;
+    for (int i = 0; i < n; ++i) {
+        p.step_value[i] = (uint8_t)spec.steps[i].first;
+        p.step_alias[i] = (uint8_t)spec.steps[i].first;
+        p.step_keep[i] = 65536;
+    }
+    while (!small.empty() && !large.empty()) {
+        int s = small.back();
+        int l = large.back();
+        small.pop_back();
+        p.step_keep[s] = (uint32_t)llround(scaled[s] * 65536);
+        p.step_alias[s] = (uint8_t)spec.steps[l].first;
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+    // Leftovers are 1.0 up to rounding: they keep their own step (65536)
+}
+
+static void buildProfile(const ProfileSpec& spec, RacerProfile& p) {
+    buildStepAlias(spec, p);
+
+    for (int i = 0; i < PROFILE_DELAY_POINTS; ++i) {
+        double us = delayQuantileMs(spec, (i + 0.5) / PROFILE_DELAY_POINTS) * 1000.0;
+        p.delay_us[i] = (uint32_t)min(us, 4.0e9);
+    }
+
+    p.burst_keep = (uint32_t)llround(spec.burst_p * 65536);
+    p.burst_length = (uint32_t)spec.burst_length;
+    p.burst_window_q40 = ((1ULL << 40) + p.burst_length - 1) / p.burst_length; // ceil(2^40 / length)
+    p.burst_scale_q16 = (uint32_t)llround(spec.burst_scale * 65536);
+
+    // Point k covers position k * RACE_LENGTH / (POINTS - 1)
+    p.fatigue_index_q32 = ((uint64_t)(PROFILE_FATIGUE_POINTS - 1) << 32) / RACE_LENGTH;
+    for (int k = 0; k < PROFILE_FATIGUE_POINTS; ++k) {
+        double x = (double)k / (PROFILE_FATIGUE_POINTS - 1);
+        double t = x <= spec.fatigue_from ? 0.0 : (x - spec.fatigue_from) / (1.0 - spec.fatigue_from);
+        if (spec.fatigue_quadratic) t *= t;
+        p.fatigue_q16[k] = (uint32_t)llround((1.0 + spec.fatigue * t) * 65536);
+    }
+}
+
+bool profilesConfigured() {
+    return !profiles.empty();
+}
+
+/**
+ * @brief Resolves racer.N.profile against the defined profiles and builds their tables.
+ *        Called once by configureRace(), after every option is known.
+ */
+bool finishProfileConfig() {
+    profiles.clear();
+    profile_names.clear();
+    racer_profile_index.assign(NUM_RACERS + 1, -1);
+
+    for (auto& entry : racer_profile_names) {
+        string who = entry.first == 0 ? string("racer.*") : "racer." + to_string(entry.first);
+        if (entry.first > NUM_RACERS) {
+            cerr << "Error: " << who << ".profile is set but there are only " << NUM_RACERS << " racers." << endl;
+            return false;
+        }
+        if (profile_specs.find(entry.second) == profile_specs.end()) {
+            cerr << "Error: " << who << ".profile: no settings for profile '" << entry.second
+                 << "' (define profile." << entry.second << ".steps, .delay, ...)." << endl;
+            return false;
+        }
+    }
+
+    auto all = racer_profile_names.find(0);
+    for (int id = 1; id <= NUM_RACERS; ++id) {
+        auto own = racer_profile_names.find(id);
+        const string* name = own != racer_profile_names.end() ? &own->second
+                           : all != racer_profile_names.end() ? &all->second : nullptr;
+        if (name == nullptr) continue;
+
+        size_t index = 0;
+        while (index < profile_names.size() && profile_names[index] != *name) index++;
+        if (index == profile_names.size()) {
+            profile_names.push_back(*name);
+            profiles.emplace_back();
+            buildProfile(profile_specs[*name], profiles.back());
+        }
+        racer_profile_index[id] = (int)index;
+    }
+    return true;
+}
+
+/**
+ * @brief The profile of racer_id, or nullptr if it uses the built-in step and delay.
+ */
+const RacerProfile* racerProfile(int racer_id) {
+    if (racer_id < 1 || racer_id >= (int)racer_profile_index.size()) return nullptr;
+    int index = racer_profile_index[racer_id];
+    return index < 0 ? nullptr : &profiles[index];
+}
+
+/**
+ * @brief One-line summary for the startup banner ("" when no racer has a profile).
+ */
+string describeRacerProfiles() {
+    if (profiles.empty()) return "";
+
+    vector<int> racers(profiles.size(), 0);
+    for (int id = 1; id <= NUM_RACERS; ++id) {
+        if (racer_profile_index[id] >= 0) racers[racer_profile_index[id]]++;
+    }
+    string text = "Racer profiles:";
+    for (size_t i = 0; i < profiles.size(); ++i) {
+        text += (i ? ", " : " ") + profile_names[i] + " (" + to_string(racers[i]) + " racers)";
+    }
+    return text;
+}
@@ -0,0 +1,78 @@
+#ifndef RACEPROFILES_H
+#define RACEPROFILES_H
+
+#include "RaceRng.h"
+#include <cstdint>
+
+// --- Racer profiles ---
+// A profile replaces the built-in step (1-4) and delay (250-400 ms) of the racers
+// assigned to it. Everything is compiled into fixed tables when the config is
+// read, so a step costs a few loads and multiplies: no division, no allocation,
+// no per-racer state beyond the RacerRng. One 64-bit draw per step, split as:
+//   bits  0-15  alias table column         bits 32-41  delay quantile
+//   bits 16-31  alias table coin           bits 48-63  burst coin (1-step windows)
+// Longer burst windows take their coin from the stream at the window's first draw
+// number, so every step of a window agrees and a seed still replays the race.
+
+const int PROFILE_MAX_STEP = 64;           // Largest step size a profile can draw
+const int PROFILE_DELAY_BITS = 10;         // Delay inverse-CDF table: 1024 quantiles
+const int PROFILE_DELAY_POINTS = 1 << PROFILE_DELAY_BITS;
+const int PROFILE_FATIGUE_POINTS = 256;    // Fatigue curve samples along the track
+const uint64_t PROFILE_BURST_SALT = 0x6a09e667f3bcc909ULL;
+
+struct RacerProfile {
+    // Step sizes: Walker/Vose alias table. Column c yields step_value[c] when the
+    // 16-bit coin is below step_keep[c] (65536 = always), else step_alias[c].
+    uint32_t step_columns;
+    uint32_t step_keep[PROFILE_MAX_STEP];
+    uint8_t step_value[PROFILE_MAX_STEP];
+    uint8_t step_alias[PROFILE_MAX_STEP];
+
+    // Delay after a step in us (before DELAY_SCALE), at quantiles (i + 0.5) / 1024
+    uint32_t delay_us[PROFILE_DELAY_POINTS];
+
+    // Burstiness: windows of burst_length steps; a window is a burst with probability
+    // burst_keep / 65536, and a burst's delays are scaled by burst_scale_q16 / 65536.
+    // Draw n is in window ((n - 1) * burst_window_q40) >> 40, exact while both n and
+    // burst_length are below 2^20 (draws never exceed MAX_RACE_LENGTH)
+    uint32_t burst_keep;
+    uint32_t burst_length;
+    uint32_t burst_scale_q16;
+    uint64_t burst_window_q40;
+
+    // Fatigue: delay multiplier (16.16) by position, sampled at PROFILE_FATIGUE_POINTS
+    // points; position p reads entry (p * fatigue_index_q32) >> 32
+    uint64_t fatigue_index_q32;
+    uint32_t fatigue_q16[PROFILE_FATIGUE_POINTS];
+};
+
+/**
+ * @brief Step size drawn by a racer with profile `p`.
+ */
+inline int profileStep(const RacerProfile& p, uint64_t draw) {
+    uint32_t column = (uint32_t)(((draw & 0xffff) * p.step_columns) >> 16);
+    uint32_t coin = (uint32_t)(draw >> 16) & 0xffff;
+    return coin < p.step_keep[column] ? p.step_value[column] : p.step_alias[column];
+}
+
+/**
+ * @brief Delay (us, before DELAY_SCALE) after the counter-th step of the stream `key`,
+ *        which left the racer at `position`.
+ */
+inline long profileDelayUs(const RacerProfile& p, uint64_t key, uint64_t counter, uint64_t draw, int position) {
+    uint64_t us = p.delay_us[(draw >> 32) & (PROFILE_DELAY_POINTS - 1)];
+
+    if (p.burst_keep != 0) {
+        uint64_t coin = draw;
+        if (p.burst_length > 1) {
+            uint64_t window_start = (((counter - 1) * p.burst_window_q40) >> 40) * p.burst_length + 1;
+            coin = racerDraw(key ^ PROFILE_BURST_SALT, window_start);
+        }
+        if ((coin >> 48) < p.burst_keep) us = (us * p.burst_scale_q16) >> 16;
+    }
+
+    uint64_t point = ((uint64_t)position * p.fatigue_index_q32) >> 32;
+    return (long)((us * p.fatigue_q16[point]) >> 16);
+}
+
+#endif // RACEPROFILES_H
@@ -0,0 +1,78 @@
+#ifndef RACERNG_H
+#define RACERNG_H
+
+#include <cstdint>
+
+// --- Counter-based racer PRNG ---
+// Every random draw of a racer is a pure function of (race seed, racer id, draw
+// number): draw n of racer i is mix64(racerStreamKey(seed, i) + n * RNG_GAMMA),
+// i.e. SplitMix64 addressed by counter. No state is shared between racers, a
+// race can be replayed bit-for-bit from its seed, and a batch loop can compute
+// the n-th draw of many racers at once (racerStepsAt) without any dependency
+// between iterations.
+
+const uint64_t RNG_GAMMA = 0x9e3779b97f4a7c15ULL; // SplitMix64 increment (golden ratio)
+
+/**
+ * @brief SplitMix64 finalizer: a bijective 64-bit mix with full avalanche.
+ */
+inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Key of racer_id's stream within the race seeded with `seed`.
+ */
+inline uint64_t racerStreamKey(uint64_t seed, uint32_t racer_id) {
+    return mix64(seed ^ mix64((uint64_t)racer_id * 0xd1b54a32d192ed03ULL));
+}
+
+/**
+ * @brief The counter-th draw (1-based) of the stream with the given key.
+ */
+inline uint64_t racerDraw(uint64_t key, uint64_t counter) {
+    return mix64(key + counter * RNG_GAMMA);
+}
+
+/**
+ * @brief Sequential view of one racer's stream (what a racer process/thread holds).
+ */
+struct RacerRng {
+    uint64_t key;
+    uint64_t counter;
+
+    RacerRng(uint64_t seed, uint32_t racer_id) : key(racerStreamKey(seed, racer_id)), counter(0) {}
+    uint64_t next() { return racerDraw(key, ++counter); }
+};
+
+// One draw per step: the low bits pick the step, the high bits the delay after it.
+
+inline int racerStep(uint64_t draw) {
+    return (int)(draw & 3) + 1; // 1-4
+}
+
+inline long racerDelayUs(uint64_t draw) {
+    // Multiply-shift range reduction instead of '%': same distribution, no division,
+    // so batch loops over many racers stay vectorizable
+    return 250000 + (long)(((draw >> 32) * 150000) >> 32); // 250-400 ms
+}
+
+/**
+ * @brief Step sizes of racers [0, n) for draw number `counter`, from their stream keys.
+ */
+inline void racerStepsAt(const uint64_t* keys, uint64_t counter, int n, int* steps) {
+    for (int i = 0; i < n; ++i) {
+        steps[i] = racerStep(racerDraw(keys[i], counter));
+    }
+}
+
+/**
+ * @brief Seed of the race after the one seeded with `seed` (a batch is reproducible from its first seed).
+ */
+inline uint64_t nextSeed(uint64_t seed) {
+    return mix64(seed + RNG_GAMMA);
+}
+
+#endif // RACERNG_H
@@ -0,0 +1,306 @@
+#include "RaceLogic.h"
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cstdlib>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+// ----------------------------------------------------------------------
+// --- RACER SCHEDULING ---
+// ----------------------------------------------------------------------
+
+// Where and how racers run, set per racer id N (or '*' for every racer) from the
+// CLI or the config file:
+//   racer.N.cpus     = 0-3,8     sched_setaffinity() CPU list
+//   racer.N.nice     = -20..19   setpriority() (below 0 needs CAP_SYS_NICE)
+//   racer.N.policy   = other | batch | idle | fifo | rr
+//   racer.N.priority = 1..99     static priority for fifo / rr
+//   pin              = none | spread  (spread: racer i on the i-th allowed CPU)
+//   step-mode        = sleep | work   (work: step delays are burned as CPU time)
+// --cpus, --nice and --policy are short for racer.*.<setting>. Each racer applies
+// its own settings (to its process or thread) before it races; anything the
+// kernel refuses is flagged in RacerSlot::sched_failed and reported at exit.
+
+int STEP_MODE = STEP_SLEEP;
+int PIN_MODE = PIN_NONE;
+
+struct RacerSchedSettings {
+    vector<int> cpus;     // Empty = inherit the monitor's affinity
+    bool nice_set = false;
+    int nice = 0;
+    int policy = -1;      // -1 = inherit
+    int priority = 0;     // SCHED_FIFO / SCHED_RR only
+};
+
+// Keyed by racer id; 0 holds the '*' defaults
+static map<int, RacerSchedSettings> sched_settings;
+
+// The monitor's own CPU set at startup, in ascending order (targets of PIN_SPREAD)
+static vector<int> allowed_cpus;
+
+/**
+ * @brief Parses "0-3,8,10-11" into a list of CPU ids.
+ */
+static bool parseCpuList(const string& name, const string& value, vector<int>& out) {
+    out.clear();
+    size_t pos = 0;
+    while (pos <= value.size()) {
+        size_t comma = value.find(',', pos);
+        string item = value.substr(pos, comma == string::npos ? string::npos : comma - pos);
+
+        char* end = nullptr;
+        long first = strtol(item.c_str(), &end, 10);
+        long last = first;
+        if (*end == '-') last = strtol(end + 1, &end, 10);
+        if (item.empty() || *end != '\0' || first < 0 || last < first || last >= CPU_SETSIZE) {
+            cerr << "Error: " << name << " must be a CPU list like '0-3,8' (CPUs 0-" << CPU_SETSIZE - 1
+                 << "), got '" << value << "'." << endl;
+            return false;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) out.push_back((int)cpu);
+
+        if (comma == string::npos) break;
+        pos = comma + 1;
+    }
+    return true;
+}
+
+static bool parsePolicy(const string& name, const string& value, int& out) {
+    if (value == "other") out = SCHED_OTHER;
+    else if (value == "batch") out = SCHED_BATCH;
+    else if (value == "idle") out = SCHED_IDLE;
+    else if (value == "fifo") out = SCHED_FIFO;
+    else if (value == "rr") out = SCHED_RR;
+    else {
+        cerr << "Error: " << name << " must be 'other', 'batch', 'idle', 'fifo' or 'rr', got '" << value << "'." << endl;
+        return false;
+    }
+    return true;
+}
+
+static bool parseBoundedInt(const string& name, const string& value, int min_value, int max_value, int& out) {
+    char* end = nullptr;
+    long parsed = strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || parsed < min_value || parsed > max_value) {
+        cerr << "Error: " << name << " must be an integer in [" << min_value << ", " << max_value
+             << "], got '" << value << "'." << endl;
+        return false;
+    }
+    out = (int)parsed;
+    return true;
+}
+
+/**
+ * @brief Applies a scheduling setting (racer.N.*, cpus, nice, policy, pin, step-mode).
+ */
+bool applySchedulingSetting(const string& key, const string& value) {
+    if (key == "pin") {
+        if (value == "none") PIN_MODE = PIN_NONE;
+        else if (value == "spread") PIN_MODE = PIN_SPREAD;
+        else {
+            cerr << "Error: pin must be 'none' or 'spread', got '" << value << "'." << endl;
+            return false;
+        }
+        return true;
+    } else if (key == "step-mode") {
+        if (value == "sleep") STEP_MODE = STEP_SLEEP;
+        else if (value == "work") STEP_MODE = STEP_WORK;
+        else {
+            cerr << "Error: step-mode must be 'sleep' or 'work', got '" << value << "'." << endl;
+            return false;
+        }
+        return true;
+    }
+
+    // "cpus" == "racer.*.cpus"; otherwise split "racer.<id|*>.<setting>"
+    int racer_id = 0;
+    string setting = key;
+    if (key.rfind("racer.", 0) == 0) {
+        size_t dot = key.find('.', 6);
+        string id = key.substr(6, dot == string::npos ? string::npos : dot - 6);
+        if (dot == string::npos || (id != "*" && !parseBoundedInt(key, id, 1, MAX_RACERS, racer_id))) {
+            cerr << "Error: expected 'racer.<id>.<setting>' or 'racer.*.<setting>', got '" << key << "'." << endl;
+            return false;
+        }
+        setting = key.substr(dot + 1);
+    }
+
+    RacerSchedSettings& s = sched_settings[racer_id];
+    if (setting == "cpus" || setting == "cpu") {
+        return parseCpuList(key, value, s.cpus);
+    } else if (setting == "nice") {
+        s.nice_set = parseBoundedInt(key, value, -20, 19, s.nice);
+        return s.nice_set;
+    } else if (setting == "policy") {
+        return parsePolicy(key, value, s.policy);
+    } else if (setting == "priority") {
+        return parseBoundedInt(key, value, 1, 99, s.priority);
+    }
+    cerr << "Error: Unknown racer setting '" << setting << "' (cpus, nice, policy, priority)." << endl;
+    return false;
+}
+
+/**
+ * @brief The effective settings of one racer: its own, falling back to the '*' defaults.
+ */
+static RacerSchedSettings resolveSettings(int racer_id) {
+    RacerSchedSettings resolved;
+    auto all = sched_settings.find(0);
+    if (all != sched_settings.end()) resolved = all->second;
+
+    auto own = sched_settings.find(racer_id);
+    if (own != sched_settings.end()) {
+        const RacerSchedSettings& s = own->second;
+        if (!s.cpus.empty()) resolved.cpus = s.cpus;
+        if (s.nice_set) {
+            resolved.nice_set = true;
+            resolved.nice = s.nice;
+        }
+        if (s.policy != -1) resolved.policy = s.policy;
+        if (s.priority != 0) resolved.priority = s.priority;
+    }
+
+    if (resolved.cpus.empty() && PIN_MODE == PIN_SPREAD && !allowed_cpus.empty()) {
+        resolved.cpus.push_back(allowed_cpus[(racer_id - 1) % allowed_cpus.size()]);
+    }
+    return resolved;
+}
+
+bool schedulingConfigured() {
+    return STEP_MODE != STEP_SLEEP || PIN_MODE != PIN_NONE || !sched_settings.empty();
+}
+
+/**
+ * @brief Checks the settings against NUM_RACERS and the CPUs we may run on.
+ *        Called once by configureRace(), after every option is known.
+ */
+bool finishSchedulingConfig() {
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    allowed_cpus.clear();
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &mask)) allowed_cpus.push_back(cpu);
+        }
+    }
+
+    // A racer's own entry is checked merged with the '*' defaults, as it will be applied
+    for (auto& entry : sched_settings) {
+        int racer_id = entry.first;
+        const RacerSchedSettings s = racer_id == 0 ? entry.second : resolveSettings(racer_id);
+        string who = racer_id == 0 ? string("racer.*") : "racer." + to_string(racer_id);
+
+        if (racer_id > NUM_RACERS) {
+            cerr << "Error: " << who << " is set but there are only " << NUM_RACERS << " racers." << endl;
+            return false;
+        }
+        for (int cpu : s.cpus) {
+            if (!allowed_cpus.empty() && !CPU_ISSET(cpu, &mask)) {
+                cerr << "Error: " << who << ": CPU " << cpu << " is not available to this process." << endl;
+                return false;
+            }
+        }
+        bool realtime = s.policy == SCHED_FIFO || s.policy == SCHED_RR;
+        if (s.priority != 0 && s.policy != -1 && !realtime) {
+            cerr << "Error: " << who << ": a priority only applies to the 'fifo' and 'rr' policies." << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Applies racer_id's affinity, nice value and policy to the calling racer (its
+ *        process, or its thread for the thread backend). Settings the kernel refuses
+ *        are recorded in the racer's slot; the racer runs on regardless.
+ */
+void applyRacerScheduling(RaceShm* shm, int racer_id) {
+    if (sched_settings.empty() && PIN_MODE == PIN_NONE) return;
+
+    RacerSchedSettings s = resolveSettings(racer_id);
+    RacerSlot* slot = racerSlot(shm, racer_id - 1);
+    unsigned failed = 0;
+
+    if (!s.cpus.empty()) {
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        for (int cpu : s.cpus) CPU_SET(cpu, &mask);
+        if (sched_setaffinity(0, sizeof(mask), &mask) == -1) failed |= SCHED_FAILED_AFFINITY;
+    }
+
+    if (s.policy != -1) {
+        struct sched_param param = {};
+        if (s.policy == SCHED_FIFO || s.policy == SCHED_RR) {
+            param.sched_priority = s.priority != 0 ? s.priority : sched_get_priority_min(s.policy);
+        }
+        if (sched_setscheduler(0, s.policy, &param) == -1) failed |= SCHED_FAILED_POLICY;
+    }
+
+    // Linux nice values are per thread: address the racer's own tid
+    if (s.nice_set && setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), s.nice) == -1) {
+        failed |= SCHED_FAILED_NICE;
+    }
+
+    __atomic_store_n(&slot->sched_failed, (uint16_t)failed, __ATOMIC_RELAXED);
+}
+
+static string policyName(int policy) {
+    switch (policy) {
+        case SCHED_OTHER: return "other";
+        case SCHED_BATCH: return "batch";
+        case SCHED_IDLE: return "idle";
+        case SCHED_FIFO: return "fifo";
+        case SCHED_RR: return "rr";
+    }
+    return "inherit";
+}
+
+/**
+ * @brief One-line summary for the startup banner ("" when nothing is configured).
+ */
+string describeRacerScheduling() {
+    if (!schedulingConfigured()) return "";
+
+    string text = string("Racer scheduling: ") + (STEP_MODE == STEP_WORK ? "CPU-bound steps" : "sleeping steps");
+    if (PIN_MODE == PIN_SPREAD) {
+        text += ", spread over " + to_string(allowed_cpus.size()) + " CPUs";
+    }
+    auto all = sched_settings.find(0);
+    if (all != sched_settings.end()) {
+        const RacerSchedSettings& s = all->second;
+        if (!s.cpus.empty()) text += ", " + to_string(s.cpus.size()) + " CPUs each";
+        if (s.nice_set) text += ", nice " + to_string(s.nice);
+        if (s.policy != -1) text += ", policy " + policyName(s.policy);
+    }
+    size_t overrides = sched_settings.size() - (all != sched_settings.end() ? 1 : 0);
+    if (overrides > 0) text += ", " + to_string(overrides) + " racer override(s)";
+    return text;
+}
+
+/**
+ * @brief Lists racers whose scheduling settings the kernel refused (e.g. fifo or a
+ *        negative nice value without CAP_SYS_NICE).
+ */
+void printSchedulingReport(RaceShm* shm) {
+    int reported = 0;
+    for (int i = 0; i < NUM_RACERS; ++i) {
+        unsigned failed = __atomic_load_n(&racerSlot(shm, i)->sched_failed, __ATOMIC_RELAXED);
+        if (failed == 0) continue;
+        if (reported++ == 10) {
+            cout << "  ... (further racers not listed)\n";
+            break;
+        }
+        cout << "Racer " << (i + 1) << ": could not apply"
+             << ((failed & SCHED_FAILED_AFFINITY) ? " cpus" : "")
+             << ((failed & SCHED_FAILED_POLICY) ? " policy" : "")
+             << ((failed & SCHED_FAILED_NICE) ? " nice" : "")
+             << " (not permitted or not available)\n";
+    }
+}
@@ -0,0 +1,283 @@
+#include "RaceLogic.h"
+#include "RaceRng.h"
+#include "RaceProfiles.h"
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+
+using namespace std;
+
+// ----------------------------------------------------------------------
+// --- MONTE CARLO SIMULATION (--simulate N) ---
+// ----------------------------------------------------------------------
+
+// Runs the race rules of runRacer() without processes, sleeps or shared memory:
+// each racer advances by racerStep() and waits racerDelayUs() per draw of its
+// RaceRng stream, and the racer with the smallest total time to reach
+// RACE_LENGTH wins (pauses are ignored). Because the streams and the seed
+// chain are the ones real races use, simulated race k has the same steps and
+// delays as race k of a headless batch started with the same --seed.
+//
+// Races are simulated a block at a time. All racers of all races in a block
+// are laid out as one structure-of-arrays (key / position / time per lane), and
+// every draw advances all lanes in one branch-free loop the compiler can
+// vectorize. Blocks are spread over all hardware threads. Racers with a profile
+// (RaceProfiles.h) sample its tables instead, in a second loop that branches per
+// lane: the table lookups are gathers the compiler would not vectorize anyway.
+
+// Lanes (race x racer) per block: keeps the SoA arrays of one thread in L1/L2
+const int SIM_BLOCK_LANES = 4096;
+
+// Races per chunk: the seeds of a chunk are chained on the main thread, then
+// the chunk's blocks are simulated in parallel
+const long SIM_CHUNK_RACES = 1 << 20;
+
+// Winning times go into a log-bucketed sketch (the scheme of the results analytics
+// sketch): bucket 0 counts 0 us, bucket b >= 1 counts (gamma^(b-2), gamma^(b-1)] us,
+// and a bucket's midpoint is within SIM_SKETCH_ACCURACY of any value in it. Memory
+// stays fixed (128 KiB per thread) however many races are simulated; a quantile or
+// CI bound narrower than 0.1% of the time shows as the same value.
+const double SIM_SKETCH_ACCURACY = 0.001;
+const double SIM_SKETCH_GAMMA = (1.0 + SIM_SKETCH_ACCURACY) / (1.0 - SIM_SKETCH_ACCURACY);
+const int SIM_SKETCH_BUCKETS = 16384; // Up to gamma^16382 us (~5 years); longer lands in the last bucket
+
+struct SimulationTally {
+    vector<double> wins;       // Per racer id; a k-way dead heat credits 1/k to each
+    vector<uint64_t> duration_sketch = vector<uint64_t>(SIM_SKETCH_BUCKETS); // Winner's time
+    long races = 0;
+    double mean_us = 0, m2_us = 0; // Welford mean and sum of squared deviations
+    long min_us = LONG_MAX, max_us = 0;
+    long dead_heats = 0;
+};
+
+static int sketchBucket(long us) {
+    if (us <= 0) return 0;
+    int bucket = 1 + (int)ceil(log((double)us) / log(SIM_SKETCH_GAMMA));
+    return bucket < SIM_SKETCH_BUCKETS ? bucket : SIM_SKETCH_BUCKETS - 1;
+}
+
+static void addDuration(SimulationTally& tally, long us) {
+    tally.duration_sketch[sketchBucket(us)]++;
+    tally.races++;
+    double delta = us - tally.mean_us;
+    tally.mean_us += delta / tally.races;
+    tally.m2_us += delta * (us - tally.mean_us);
+    tally.min_us = min(tally.min_us, us);
+    tally.max_us = max(tally.max_us, us);
+}
+
+/**
+ * @brief Adds tally `from` into `into` (Chan et al. for the mean and variance).
+ */
+static void mergeTally(SimulationTally& into, const SimulationTally& from) {
+    for (size_t id = 0; id < into.wins.size(); ++id) into.wins[id] += from.wins[id];
+    for (int b = 0; b < SIM_SKETCH_BUCKETS; ++b) into.duration_sketch[b] += from.duration_sketch[b];
+    if (from.races > 0) {
+        long races = into.races + from.races;
+        double delta = from.mean_us - into.mean_us;
+        into.m2_us += from.m2_us + delta * delta * into.races * from.races / races;
+        into.mean_us += delta * from.races / races;
+        into.races = races;
+    }
+    into.min_us = min(into.min_us, from.min_us);
+    into.max_us = max(into.max_us, from.max_us);
+    into.dead_heats += from.dead_heats;
+}
+
+/**
+ * @brief Winning time of the race at 0-based `rank` in time order, from the sketch.
+ */
+static double sketchValueAt(const SimulationTally& tally, long rank) {
+    long seen = 0;
+    for (int b = 0; b < SIM_SKETCH_BUCKETS; ++b) {
+        seen += tally.duration_sketch[b];
+        if (seen <= rank) continue;
+        double value = b == 0 ? 0.0 : 2.0 * pow(SIM_SKETCH_GAMMA, b - 1) / (SIM_SKETCH_GAMMA + 1.0);
+        return min(max(value, (double)tally.min_us), (double)tally.max_us);
+    }
+    return (double)tally.max_us;
+}
+
+/**
+ * @brief Simulates races [first, last) of `seeds` and adds them to `tally`.
+ */
+static void simulateRaces(const vector<uint64_t>& seeds, long first, long last, SimulationTally& tally) {
+    const int n = NUM_RACERS;
+    const int races_per_block = max(1, SIM_BLOCK_LANES / n);
+    const int max_lanes = races_per_block * n;
+
+    vector<uint64_t> key(max_lanes);
+    vector<int> position(max_lanes);
+    vector<long> time_us(max_lanes);
+
+    // Profile of every lane (nullptr = built-in draw); lane r * n + i is racer i + 1
+    bool use_profiles = profilesConfigured();
+    vector<const RacerProfile*> lane_profile(max_lanes);
+    for (int lane = 0; lane < max_lanes; ++lane) {
+        lane_profile[lane] = racerProfile(lane % n + 1);
+    }
+
+    for (long block = first; block < last; block += races_per_block) {
+        int races = (int)min<long>(races_per_block, last - block);
+        int lanes = races * n;
+
+        for (int r = 0; r < races; ++r) {
+            for (int i = 0; i < n; ++i) {
+                key[r * n + i] = racerStreamKey(seeds[block + r], i + 1);
+            }
+        }
+        fill(position.begin(), position.begin() + lanes, 0);
+        fill(time_us.begin(), time_us.begin() + lanes, 0);
+
+        // Every lane takes one step per draw until it reaches the finish; finished
+        // lanes are masked rather than branched around
+        uint64_t* __restrict k = key.data();
+        int* __restrict pos = position.data();
+        long* __restrict t = time_us.data();
+        int active = lanes;
+        for (uint64_t draw_no = 1; use_profiles && active > 0; ++draw_no) {
+            active = 0;
+            for (int lane = 0; lane < lanes; ++lane) {
+                if (pos[lane] >= RACE_LENGTH) continue;
+                const RacerProfile* p = lane_profile[lane];
+                uint64_t draw = racerDraw(k[lane], draw_no);
+                pos[lane] += p != nullptr ? profileStep(*p, draw) : racerStep(draw);
+                if (pos[lane] < RACE_LENGTH) {
+                    t[lane] += p != nullptr ? profileDelayUs(*p, k[lane], draw_no, draw, pos[lane]) : racerDelayUs(draw);
+                    active++;
+                }
+            }
+        }
+        for (uint64_t draw_no = 1; active > 0; ++draw_no) {
+            active = 0;
+            for (int lane = 0; lane < lanes; ++lane) {
+                uint64_t draw = racerDraw(k[lane], draw_no);
+                int running = pos[lane] < RACE_LENGTH;
+                pos[lane] += running * racerStep(draw);
+                // The finish is stamped right after the last step, before its delay
+                int still_running = pos[lane] < RACE_LENGTH;
+                t[lane] += still_running * racerDelayUs(draw);
+                active += still_running;
+            }
+        }
+
+        for (int r = 0; r < races; ++r) {
+            const long* race_t = t + r * n;
+            long best = *min_element(race_t, race_t + n);
+            int tied = (int)count(race_t, race_t + n, best);
+            for (int i = 0; i < n; ++i) {
+                if (race_t[i] == best) tally.wins[i + 1] += 1.0 / tied;
+            }
+            if (tied > 1) tally.dead_heats++;
+            addDuration(tally, best);
+        }
+    }
+}
+
+/**
+ * @brief Wilson score interval for a binomial proportion (95%).
+ */
+static void wilsonInterval(double p, double n, double& low, double& high) {
+    const double z = 1.96;
+    double denom = 1.0 + z * z / n;
+    double centre = (p + z * z / (2 * n)) / denom;
+    double half = z * sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / denom;
+    low = max(0.0, centre - half);
+    high = min(1.0, centre + half);
+}
+
+/**
+ * @brief Runs SIMULATE_RACES simulated races and prints win probabilities and the
+ *        winning-time distribution with 95% confidence intervals.
+ */
+void runSimulation() {
+    long total = SIMULATE_RACES;
+    unsigned threads = thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    uint64_t seed = RACE_SEED_SET ? RACE_SEED : mix64((uint64_t)chrono::system_clock::now().time_since_epoch().count());
+    uint64_t first_seed = seed;
+
+    cout << "Simulating " << total << " races, " << NUM_RACERS << " racers, length " << RACE_LENGTH
+         << " on " << threads << " threads\n";
+    if (profilesConfigured()) {
+        cout << describeRacerProfiles() << "\n";
+    }
+
+    vector<SimulationTally> tallies(threads);
+    for (SimulationTally& tally : tallies) tally.wins.assign(NUM_RACERS + 1, 0.0);
+
+    auto run_start = chrono::steady_clock::now();
+    vector<uint64_t> seeds;
+    for (long done = 0; done < total; done += SIM_CHUNK_RACES) {
+        long chunk = min(SIM_CHUNK_RACES, total - done);
+        seeds.resize(chunk);
+        for (long r = 0; r < chunk; ++r) {
+            seeds[r] = seed;
+            seed = nextSeed(seed);
+        }
+
+        vector<thread> workers;
+        long per_thread = (chunk + threads - 1) / threads;
+        for (unsigned w = 0; w < threads; ++w) {
+            long first = w * per_thread;
+            long last = min(chunk, first + per_thread);
+            if (first >= last) break;
+            workers.emplace_back(simulateRaces, cref(seeds), first, last, ref(tallies[w]));
+        }
+        for (thread& t : workers) t.join();
+    }
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - run_start).count();
+
+    // Merge the per-thread tallies
+    SimulationTally all;
+    all.wins.assign(NUM_RACERS + 1, 0.0);
+    for (SimulationTally& tally : tallies) {
+        mergeTally(all, tally);
+    }
+
+    printf("Elapsed: %.3f s | %.0f races/s | dead heats: %ld\n", elapsed, total / elapsed, all.dead_heats);
+    printf("Seed: %llu (a headless batch with --seed replays these races)\n", (unsigned long long)first_seed);
+
+    // Win probabilities, most likely first (top 20 for large fields)
+    vector<int> ranking;
+    for (int id = 1; id <= NUM_RACERS; ++id) ranking.push_back(id);
+    stable_sort(ranking.begin(), ranking.end(), [&all](int a, int b) { return all.wins[a] > all.wins[b]; });
+    size_t shown = ranking.size() > 20 ? 20 : ranking.size();
+
+    cout << "Win probability" << (shown < ranking.size() ? " (top 20)" : "") << ", 95% CI:\n";
+    for (size_t i = 0; i < shown; ++i) {
+        int id = ranking[i];
+        double p = all.wins[id] / total;
+        double low, high;
+        wilsonInterval(p, (double)total, low, high);
+        printf("  Racer %-5d %6.2f%%  [%6.2f%%, %6.2f%%]\n", id, 100.0 * p, 100.0 * low, 100.0 * high);
+    }
+
+    // Winning time: mean with a normal-approximation CI, quantiles with
+    // order-statistic CIs (ranks n*q +- 1.96*sqrt(n*q*(1-q))) read from the sketch
+    double scale = DELAY_SCALE / 1000.0; // us of model time -> ms at the configured delay scale
+    long races = all.races;
+    double mean = all.mean_us;
+    double sd = races > 1 ? sqrt(all.m2_us / (races - 1)) : 0.0;
+    double half = 1.96 * sd / sqrt((double)races);
+
+    printf("Winning time (ms, delay scale %g): mean %.1f [%.1f, %.1f]\n",
+           DELAY_SCALE, mean * scale, (mean - half) * scale, (mean + half) * scale);
+    const double quantiles[] = {0.05, 0.25, 0.50, 0.75, 0.95};
+    for (double q : quantiles) {
+        double n = (double)races;
+        double spread = 1.96 * sqrt(n * q * (1 - q));
+        long rank = min<long>((long)(n * q), races - 1);
+        long low = max<long>(0, (long)floor(n * q - spread));
+        long high = min<long>(races - 1, (long)ceil(n * q + spread));
+        printf("  p%-3.0f %10.1f  [%.1f, %.1f]\n", q * 100, sketchValueAt(all, rank) * scale,
+               sketchValueAt(all, low) * scale, sketchValueAt(all, high) * scale);
+    }
+}
@@ -0,0 +1,107 @@
+#include "RaceLogic.h"
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// ----------------------------------------------------------------------
+// --- LATENCY STATS EXPORT (--stats-out FILE) ---
+// ----------------------------------------------------------------------
+
+// One JSON object: run parameters, every histogram (summary quantiles plus the
+// non-empty buckets as [lower_bound_us, count] pairs) and the per-racer
+// counters. Written once at exit, after the racers have stopped. With
+// --concurrent the histograms and counters are summed over every race.
+
+/**
+ * @brief Adds histogram `from` into `into` (counts and buckets add, max is kept).
+ */
+static void mergeHistogram(LatencyHistogram* into, const LatencyHistogram* from) {
+    into->count += from->count;
+    into->sum_us += from->sum_us;
+    if (from->max_us > into->max_us) into->max_us = from->max_us;
+    for (int b = 0; b < HIST_BUCKETS; ++b) {
+        into->buckets[b] += from->buckets[b];
+    }
+}
+
+static void writeHistogramJson(FILE* out, const char* name, const LatencyHistogram* h, bool last) {
+    uint64_t count = h->count;
+    fprintf(out, "    \"%s\": {\"count\": %llu, \"mean_us\": %.1f, \"p50_us\": %llu, \"p90_us\": %llu, "
+                 "\"p99_us\": %llu, \"p999_us\": %llu, \"max_us\": %llu, \"buckets\": [",
+            name, (unsigned long long)count, count ? (double)h->sum_us / count : 0.0,
+            (unsigned long long)histQuantile(h, 0.50), (unsigned long long)histQuantile(h, 0.90),
+            (unsigned long long)histQuantile(h, 0.99), (unsigned long long)histQuantile(h, 0.999),
+            (unsigned long long)h->max_us);
+
+    bool first = true;
+    for (int b = 0; b < HIST_BUCKETS; ++b) {
+        if (h->buckets[b] == 0) continue;
+        fprintf(out, "%s[%llu, %llu]", first ? "" : ", ",
+                (unsigned long long)histBucketLow(b), (unsigned long long)h->buckets[b]);
+        first = false;
+    }
+    fprintf(out, "]}%s\n", last ? "" : ",");
+}
+
+/**
+ * @brief Writes the latency histograms and per-racer counters of the arena `shm` to
+ *        `path` as JSON.
+ */
+bool writeRaceStatsJson(RaceShm* shm, const string& path) {
+    FILE* out = fopen(path.c_str(), "w");
+    if (out == nullptr) {
+        cerr << "Error: Could not write stats to '" << path << "': " << strerror(errno) << endl;
+        return false;
+    }
+
+    fprintf(out, "{\n  \"racers\": %d,\n  \"race_length\": %d,\n  \"backend\": \"%s\",\n  \"sync\": \"%s\",\n"
+                 "  \"step_mode\": \"%s\",\n  \"concurrent_races\": %d,\n",
+            NUM_RACERS, RACE_LENGTH, RACE_BACKEND == BACKEND_THREAD ? "thread" : (PREFORK ? "prefork" : "fork"),
+            SYNC_MODE == SYNC_EVENT ? "event" : "poll", STEP_MODE == STEP_WORK ? "work" : "sleep",
+            CONCURRENT_RACES);
+
+    fprintf(out, "  \"histograms\": {\n");
+    static RaceStats merged; // ~16 KB: kept off the stack
+    merged = *raceStats(shm);
+    for (int race = 1; race < CONCURRENT_RACES; ++race) {
+        for (int i = 0; i < HIST_COUNT; ++i) {
+            mergeHistogram(&merged.hist[i], &raceStats(raceBlock(shm, race))->hist[i]);
+        }
+    }
+    for (int i = 0; i < HIST_COUNT; ++i) {
+        writeHistogramJson(out, HIST_NAMES[i], &merged.hist[i], i == HIST_COUNT - 1);
+    }
+    fprintf(out, "  },\n");
+
+    fprintf(out, "  \"racer_counters\": [\n");
+    for (int i = 0; i < NUM_RACERS; ++i) {
+        RacerSlot* slot = racerSlot(shm, i);
+        int steps = 0, races_served = 0, migrations = 0;
+        long paused_us = 0, cpu_us = 0;
+        unsigned sched_failed = 0;
+        for (int race = 0; race < CONCURRENT_RACES; ++race) {
+            RacerSlot* lane_slot = racerSlot(raceBlock(shm, race), i);
+            steps += lane_slot->steps;
+            races_served += lane_slot->races_served;
+            migrations += lane_slot->migrations;
+            paused_us += lane_slot->paused_us;
+            cpu_us += lane_slot->cpu_us;
+            sched_failed |= lane_slot->sched_failed;
+        }
+        fprintf(out, "    {\"id\": %d, \"steps\": %d, \"paused_us\": %ld, \"races_served\": %d, \"cpu_us\": %ld, "
+                     "\"migrations\": %d, \"last_cpu\": %d, \"sched_failed\": %u}%s\n",
+                i + 1, steps, paused_us, races_served, cpu_us,
+                migrations, slot->cpu, sched_failed, i == NUM_RACERS - 1 ? "" : ",");
+    }
+    fprintf(out, "  ]\n}\n");
+
+    bool ok = fclose(out) == 0;
+    if (ok) {
+        cout << "Latency stats written to " << path << "\n";
+    }
+    return ok;
+}
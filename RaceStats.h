@@ -0,0 +1,108 @@
+#ifndef RACESTATS_H
+#define RACESTATS_H
+
+#include <cstdint>
+#include <ctime>
+
+// --- Latency instrumentation (lives in the race segment, after finish_order) ---
+// HDR-style histograms of microsecond latencies: values below 16 us get exact
+// buckets, above that every power of two is split into 8 linear sub-buckets,
+// so any recorded value is within 12.5% of its bucket's lower bound. Racers
+// and the monitor record with relaxed atomics; nothing here ever blocks.
+
+const int HIST_EXACT = 16;    // Values [0, 16) have one bucket each
+const int HIST_SUB_BITS = 3;  // 8 sub-buckets per power of two above that
+const int HIST_BUCKETS = 256; // Up to 2^35 us (~9.5 h); larger values land in the last bucket
+
+struct alignas(64) LatencyHistogram {
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t max_us;
+    uint64_t buckets[HIST_BUCKETS];
+};
+
+// What is measured (one histogram each)
+enum LatencyHistogramId {
+    HIST_SEEN_RUNNING = 0, // Status set -> a racer observes RUNNING (start/resume)
+    HIST_SEEN_PAUSED,      // Status set -> a racer observes PAUSED
+    HIST_SEEN_FINISHED,    // Status set -> a racer observes FINISHED
+    HIST_SEEN_EXITING,     // Status set -> a racer observes EXITING
+    HIST_INPUT_TO_STATUS,  // Monitor wakes with a key -> the resulting status is stored
+    HIST_FRAME,            // Time to draw one monitor frame
+    HIST_STEP_TO_DRAW,     // Racer step -> the new position is drawn (staleness)
+    HIST_PAUSE,            // Length of each pause as seen by a racer
+    HIST_COUNT
+};
+
+const char* const HIST_NAMES[HIST_COUNT] = {
+    "seen_running", "seen_paused", "seen_finished", "seen_exiting",
+    "input_to_status", "frame", "step_to_draw", "pause",
+};
+
+struct alignas(64) RaceStats {
+    LatencyHistogram hist[HIST_COUNT];
+};
+
+/**
+ * @brief CLOCK_MONOTONIC in microseconds (system-wide, so comparable across racer processes).
+ */
+inline long monotonic_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief CLOCK_REALTIME in milliseconds since the epoch (race start and finish times).
+ */
+inline long wall_clock_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000;
+}
+
+inline int histBucket(uint64_t value_us) {
+    if (value_us < (uint64_t)HIST_EXACT) return (int)value_us;
+    int msb = 63 - __builtin_clzll(value_us);
+    int shift = msb - HIST_SUB_BITS;
+    int bucket = shift * (1 << HIST_SUB_BITS) + (int)(value_us >> shift);
+    return bucket < HIST_BUCKETS ? bucket : HIST_BUCKETS - 1;
+}
+
+/**
+ * @brief Smallest value that falls into `bucket`.
+ */
+inline uint64_t histBucketLow(int bucket) {
+    if (bucket < HIST_EXACT) return (uint64_t)bucket;
+    int shift = bucket / (1 << HIST_SUB_BITS) - 1;
+    uint64_t mantissa = (uint64_t)(bucket % (1 << HIST_SUB_BITS) + (1 << HIST_SUB_BITS));
+    return mantissa << shift;
+}
+
+inline void recordLatency(LatencyHistogram* h, long value_us) {
+    if (value_us < 0) value_us = 0;
+    __atomic_fetch_add(&h->buckets[histBucket((uint64_t)value_us)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->sum_us, (uint64_t)value_us, __ATOMIC_RELAXED);
+    uint64_t seen = __atomic_load_n(&h->max_us, __ATOMIC_RELAXED);
+    while ((uint64_t)value_us > seen &&
+           !__atomic_compare_exchange_n(&h->max_us, &seen, (uint64_t)value_us, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * @brief Value at quantile q (0-1), reported as the lower bound of its bucket.
+ */
+inline uint64_t histQuantile(const LatencyHistogram* h, double q) {
+    uint64_t total = __atomic_load_n(&h->count, __ATOMIC_RELAXED);
+    if (total == 0) return 0;
+    uint64_t rank = (uint64_t)(q * (total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; ++b) {
+        seen += __atomic_load_n(&h->buckets[b], __ATOMIC_RELAXED);
+        if (seen >= rank) return histBucketLow(b);
+    }
+    return __atomic_load_n(&h->max_us, __ATOMIC_RELAXED);
+}
+
+#endif // RACESTATS_H
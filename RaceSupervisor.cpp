@@ -0,0 +1,177 @@
+#include "RaceLogic.h"
+#include <iostream>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <dirent.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/signalfd.h>
+#include <sys/prctl.h>
+#include <sys/shm.h>
+#include <sys/mman.h>
+
+using namespace std;
+
+// ----------------------------------------------------------------------
+// --- SUPERVISOR ---
+// ----------------------------------------------------------------------
+
+// The monitor takes SIGCHLD, SIGINT, SIGTERM and SIGHUP through a signalfd
+// instead of handlers: the signals are blocked at startup (so racer threads
+// inherit the mask) and the fd is polled next to stdin and the racer eventfd.
+//   SIGCHLD           -> reapRacers(): dead racers are reaped and, if they died
+//                        mid-race, marked DNF in shared memory
+//   SIGINT/TERM/HUP   -> status EXITING in every race, i.e. the same clean shutdown as 'Q'
+// Forked racers undo this in prepareRacerChild() and ask the kernel to kill
+// them if the monitor dies, so a crashed monitor leaves no orphaned racers.
+
+int supervisor_fd = -1;
+
+static sigset_t supervised_signals;
+static sigset_t original_mask;
+static pid_t monitor_pid = 0;
+
+/**
+ * @brief Blocks the supervised signals and opens the signalfd. Must run before any
+ *        racer thread or process is started.
+ */
+bool initSupervisor() {
+    sigemptyset(&supervised_signals);
+    sigaddset(&supervised_signals, SIGCHLD);
+    sigaddset(&supervised_signals, SIGINT);
+    sigaddset(&supervised_signals, SIGTERM);
+    sigaddset(&supervised_signals, SIGHUP);
+
+    if (sigprocmask(SIG_BLOCK, &supervised_signals, &original_mask) == -1) {
+        perror("sigprocmask failed");
+        return false;
+    }
+    supervisor_fd = signalfd(-1, &supervised_signals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (supervisor_fd == -1) {
+        perror("signalfd failed");
+        sigprocmask(SIG_SETMASK, &original_mask, nullptr);
+        return false;
+    }
+    monitor_pid = getpid();
+    return true;
+}
+
+void closeSupervisor() {
+    if (supervisor_fd != -1) {
+        close(supervisor_fd);
+        supervisor_fd = -1;
+    }
+}
+
+/**
+ * @brief Drains the signalfd. Reaps racers on SIGCHLD and starts a clean shutdown
+ *        of every race in the arena `shm` on SIGINT/SIGTERM/SIGHUP.
+ * @return true if a shutdown was requested.
+ */
+bool handleSupervisorEvents(RaceShm* shm) {
+    if (supervisor_fd == -1) return false;
+
+    bool child_exited = false;
+    bool terminate = false;
+    struct signalfd_siginfo info;
+    while (read(supervisor_fd, &info, sizeof(info)) == (ssize_t)sizeof(info)) {
+        if (info.ssi_signo == SIGCHLD) {
+            child_exited = true;
+        } else {
+            terminate = true;
+        }
+    }
+
+    // SIGCHLDs coalesce, so one pass reaps every racer that has exited
+    if (child_exited) {
+        reapRacers();
+    }
+    for (int race = 0; terminate && race < CONCURRENT_RACES; ++race) {
+        if (getRaceStatus(raceBlock(shm, race)) != EXITING) {
+            setRaceStatus(raceBlock(shm, race), EXITING);
+        }
+    }
+    return terminate;
+}
+
+/**
+ * @brief Run in every forked racer right after fork(): restores the signal mask, leaves
+ *        SIGINT (terminal Ctrl-C) to the monitor and dies together with the monitor.
+ */
+void prepareRacerChild() {
+    if (supervisor_fd != -1) {
+        close(supervisor_fd);
+        supervisor_fd = -1;
+    }
+    dropStatsExport();
+    signal(SIGINT, SIG_IGN);
+    sigprocmask(SIG_SETMASK, &original_mask, nullptr);
+
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+    if (monitor_pid != 0 && getppid() != monitor_pid) {
+        _exit(EXIT_FAILURE); // The monitor died before the death signal was armed
+    }
+}
+
+static bool processGone(pid_t pid) {
+    return kill(pid, 0) == -1 && errno == ESRCH;
+}
+
+/**
+ * @brief Unlinks POSIX segments ("/process_race.<pid>") whose monitor died between
+ *        shm_open() and the immediate shm_unlink() in mapSharedSegment().
+ */
+static int removeStalePosixSegments() {
+    DIR* dir = opendir("/dev/shm");
+    if (dir == nullptr) return 0;
+
+    int removed = 0;
+    const string prefix = "process_race.";
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        string name = entry->d_name;
+        if (name.compare(0, prefix.size(), prefix) != 0) continue;
+        pid_t pid = (pid_t)atol(name.c_str() + prefix.size());
+        if (pid > 0 && processGone(pid) && shm_unlink(("/" + name).c_str()) == 0) {
+            removed++;
+        }
+    }
+    closedir(dir);
+    return removed;
+}
+
+/**
+ * @brief Removes race segments leaked by earlier runs whose monitor died before it could
+ *        clean up. SysV: ours (same uid, RACE_SHM_MAGIC), unattached, creator gone.
+ *        POSIX: named after a monitor pid that no longer exists.
+ * @return Number of segments removed.
+ */
+int removeStaleSegments() {
+    int removed = removeStalePosixSegments();
+
+    struct shm_info info;
+    int max_index = shmctl(0, SHM_INFO, reinterpret_cast<struct shmid_ds*>(&info));
+    for (int index = 0; index <= max_index; ++index) {
+        struct shmid_ds ds;
+        int shmid = shmctl(index, SHM_STAT, &ds);
+        if (shmid < 0) continue;
+        if (ds.shm_perm.uid != getuid() || ds.shm_nattch != 0 || ds.shm_segsz < sizeof(RaceShm)) continue;
+        if (!processGone(ds.shm_cpid)) continue; // Creator (a live monitor) may still use it
+
+        void* addr = shmat(shmid, nullptr, SHM_RDONLY);
+        if (addr == (void*)-1) continue;
+        bool ours = static_cast<RaceShm*>(addr)->magic == RACE_SHM_MAGIC;
+        shmdt(addr);
+
+        if (ours && shmctl(shmid, IPC_RMID, nullptr) == 0) {
+            removed++;
+        }
+    }
+    if (removed > 0) {
+        cout << "Removed " << removed << " stale race segment(s) left by earlier runs.\n";
+    }
+    return removed;
+}
@@ -0,0 +1,243 @@
+#include "RaceLogic.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+
+using namespace std;
+
+// ----------------------------------------------------------------------
+// --- ELIMINATION TOURNAMENT (--tournament N) ---
+// ----------------------------------------------------------------------
+
+// N entrants race in heats of NUM_RACERS; the first PODIUM_SIZE across the line
+// of each heat advance, and the round whose field fits one heat is the final.
+// Every heat is an ordinary race on one lane of the arena (with its own seed and
+// result log entry), so the heats of a round run side by side on up to
+// CONCURRENT_RACES lanes, a lane taking the next heat as soon as its last one
+// finished. Rounds are barriers: the next field is seeded from the finish order
+// of the whole round (place in heat first, then finish time), and spread over
+// the heats in snake order, so the strongest finishers meet as late as possible.
+// Entrants are not racers: entrant e runs as whichever racer id owns its lane in
+// the heat, and a heat with fewer entrants than lanes scratches the empty ones.
+// A heat of one entrant (the snake draw gives it to the best seed) is not raced:
+// that entrant gets a bye into the next round.
+
+const size_t BRACKET_HEATS_SHOWN = 16; // Heats printed per round; the results log has all of them
+
+struct TournamentHeat {
+    vector<int> entrants;  // By lane: entrants[i] runs as racer i + 1
+    RaceResult result;
+    long wall_us = 0;      // Start of the racers to result collected
+};
+
+/**
+ * @brief Starts `heat` on lane `race`: lanes without an entrant are scratched (DNF)
+ *        before the racers see RUNNING.
+ */
+static void startHeat(RaceShm* race, const TournamentHeat& heat) {
+    start_race_processes(race);
+    for (int id = (int)heat.entrants.size() + 1; id <= NUM_RACERS; ++id) {
+        markRacerDnf(race, id);
+    }
+    race->start_time_ms = wall_clock_ms();
+    setRaceStatus(race, RUNNING);
+}
+
+static bool isBye(const TournamentHeat& heat) {
+    return heat.entrants.size() < 2;
+}
+
+/**
+ * @brief Entrants of `heat` that go through to the next round (byes included). Every
+ *        raced heat eliminates at least one entrant.
+ */
+static size_t advancingFrom(const TournamentHeat& heat) {
+    return isBye(heat) ? heat.entrants.size() : min<size_t>(PODIUM_SIZE, heat.entrants.size() - 1);
+}
+
+/**
+ * @brief Runs every heat of a round except byes, up to CONCURRENT_RACES at a time.
+ * @return false if the run was aborted (SIGINT/SIGTERM or a failed race).
+ */
+static bool runRound(RaceShm* shm, vector<TournamentHeat>& heats) {
+    size_t to_run = 0;
+    for (const TournamentHeat& heat : heats) {
+        if (!isBye(heat)) to_run++;
+    }
+    int lanes = CONCURRENT_RACES < (int)to_run ? CONCURRENT_RACES : (int)to_run;
+    vector<bool> lane_busy(lanes, false);
+    vector<size_t> lane_heat(lanes, 0);
+    vector<long> lane_start_us(lanes, 0);
+    size_t next = 0;
+    size_t done = 0;
+
+    while (done < to_run) {
+        for (int lane = 0; lane < lanes; ++lane) {
+            while (next < heats.size() && isBye(heats[next])) next++;
+            if (next == heats.size()) break;
+            if (lane_busy[lane]) continue;
+            lane_start_us[lane] = monotonic_us();
+            startHeat(raceBlock(shm, lane), heats[next]);
+            lane_heat[lane] = next++;
+            lane_busy[lane] = true;
+        }
+
+        waitForRaceProgress(shm, lane_busy, 100);
+        handleSupervisorEvents(shm);
+        drainRaceTrace(shm);
+        serviceStatsExport(shm);
+
+        for (int lane = 0; lane < lanes; ++lane) {
+            if (!lane_busy[lane]) continue;
+            RaceShm* race = raceBlock(shm, lane);
+            int status = getRaceStatus(race);
+            if (status == RUNNING) continue;
+            if (status != FINISHED) return false;
+
+            TournamentHeat& heat = heats[lane_heat[lane]];
+            heat.result = collectRaceResult(race);
+            heat.wall_us = monotonic_us() - lane_start_us[lane];
+            logRaceResult(heat.result);
+            publishStatsResult(lane, heat.result);
+            lane_busy[lane] = false;
+            done++;
+        }
+    }
+    flushResultsLog();
+    return true;
+}
+
+/**
+ * @brief Splits `field` (best seed first) into heats of at most NUM_RACERS, in snake
+ *        order: seeds 1..h go to heats 1..h, seeds h+1..2h to heats h..1, and so on.
+ */
+static vector<TournamentHeat> drawHeats(const vector<int>& field) {
+    size_t count = (field.size() + NUM_RACERS - 1) / NUM_RACERS;
+    vector<TournamentHeat> heats(count);
+    for (size_t seed = 0; seed < field.size(); ++seed) {
+        size_t pass = seed / count;
+        size_t column = seed % count;
+        heats[pass % 2 == 0 ? column : count - 1 - column].entrants.push_back(field[seed]);
+    }
+    return heats;
+}
+
+/**
+ * @brief One bracket line: the heat's field and its finishers (entrant, time).
+ */
+static void printHeat(size_t index, const TournamentHeat& heat, size_t advancing) {
+    if (isBye(heat)) {
+        printf("  Heat %-4zu bye: E%d\n", index + 1, heat.entrants[0]);
+        return;
+    }
+    printf("  Heat %-4zu seed %-20llu", index + 1, (unsigned long long)heat.result.seed);
+    const RaceResult& r = heat.result;
+    for (size_t place = 0; place < r.finish_order.size(); ++place) {
+        int id = r.finish_order[place];
+        if (id < 1 || id > (int)heat.entrants.size()) continue;
+        printf(" %s%zu. E%d %ldms", place == advancing ? " |" : "", place + 1, heat.entrants[id - 1], r.finish_ms[place]);
+    }
+    printf("  (%zu entrants)\n", heat.entrants.size());
+}
+
+/**
+ * @brief Runs a TOURNAMENT_ENTRANTS-entrant elimination tournament and prints the
+ *        bracket, the champion and the wall-clock time against running every heat
+ *        one after another.
+ */
+void runTournament(RaceShm* shm) {
+    vector<int> field(TOURNAMENT_ENTRANTS);
+    for (int e = 0; e < TOURNAMENT_ENTRANTS; ++e) field[e] = e + 1;
+
+    cout << "Tournament: " << TOURNAMENT_ENTRANTS << " entrants, heats of " << NUM_RACERS << ", top "
+         << PODIUM_SIZE << " advance, up to " << CONCURRENT_RACES << " heat(s) at a time, length "
+         << RACE_LENGTH << ", delay scale " << DELAY_SCALE << "\n";
+
+    long tournament_start_us = monotonic_us();
+    long serial_us = 0; // Sum of heat times: the same tournament on a single lane
+    int heats_run = 0;
+    vector<int> podium;
+    bool aborted = false;
+
+    for (int round = 1; !aborted && field.size() > 1; ++round) {
+        bool final_round = field.size() <= (size_t)NUM_RACERS;
+        vector<TournamentHeat> heats = drawHeats(field);
+
+        long round_start_us = monotonic_us();
+        aborted = !runRound(shm, heats);
+        if (aborted) break;
+        long round_wall_us = monotonic_us() - round_start_us;
+
+        // Advancers keep their place and time: the next field is ordered by place in
+        // heat, then finish time, with byes (which finished nothing) first. Every raced
+        // heat eliminates at least one entrant, and a round with a bye always has one.
+        struct Advancer {
+            int entrant;
+            size_t place;
+            long finish_ms;
+        };
+        vector<Advancer> advancers;
+        long round_heats_us = 0;
+        for (const TournamentHeat& heat : heats) {
+            if (isBye(heat)) {
+                advancers.push_back({heat.entrants[0], 0, -1});
+                continue;
+            }
+            round_heats_us += heat.wall_us;
+            heats_run++;
+            const RaceResult& r = heat.result;
+            size_t advancing = advancingFrom(heat);
+            for (size_t place = 0; place < r.finish_order.size() && place < advancing; ++place) {
+                int id = r.finish_order[place];
+                if (id < 1 || id > (int)heat.entrants.size()) continue;
+                advancers.push_back({heat.entrants[id - 1], place, r.finish_ms[place]});
+            }
+        }
+        stable_sort(advancers.begin(), advancers.end(), [](const Advancer& a, const Advancer& b) {
+            return a.place != b.place ? a.place < b.place : a.finish_ms < b.finish_ms;
+        });
+        serial_us += round_heats_us;
+
+        printf("Round %d%s: %zu entrants in %zu heat(s) | wall %.3f s, heats %.3f s serial\n",
+               round, final_round ? " (final)" : "", field.size(), heats.size(),
+               round_wall_us / 1e6, round_heats_us / 1e6);
+        for (size_t h = 0; h < heats.size() && h < BRACKET_HEATS_SHOWN; ++h) {
+            printHeat(h, heats[h], final_round ? heats[h].entrants.size() : advancingFrom(heats[h]));
+        }
+        if (heats.size() > BRACKET_HEATS_SHOWN) {
+            printf("  ... %zu more heat(s) in the results log\n", heats.size() - BRACKET_HEATS_SHOWN);
+        }
+
+        if (final_round) {
+            for (size_t place = 0; place < heats[0].result.finish_order.size(); ++place) {
+                int id = heats[0].result.finish_order[place];
+                if (id >= 1 && id <= (int)heats[0].entrants.size()) podium.push_back(heats[0].entrants[id - 1]);
+            }
+            break;
+        }
+
+        field.clear();
+        for (const Advancer& a : advancers) field.push_back(a.entrant);
+        if (field.empty()) {
+            cout << "No entrant finished a heat of round " << round << ".\n";
+            break;
+        }
+    }
+    if (podium.empty() && field.size() == 1) {
+        podium.push_back(field[0]); // Everyone else was eliminated before a final was needed
+    }
+
+    double wall = (monotonic_us() - tournament_start_us) / 1e6;
+    if (aborted) {
+        cout << "Tournament aborted.\n";
+    } else if (!podium.empty()) {
+        cout << "Champion: Entrant " << podium[0];
+        for (size_t place = 1; place < podium.size(); ++place) {
+            cout << (place == 1 ? " | then " : ", ") << "E" << podium[place];
+        }
+        cout << "\n";
+    }
+    printf("Tournament wall-clock: %.3f s for %d heat(s) | serial (heats one after another): %.3f s | speedup %.2fx\n",
+           wall, heats_run, serial_us / 1e6, wall > 0 ? serial_us / 1e6 / wall : 0.0);
+}
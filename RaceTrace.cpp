@@ -0,0 +1,556 @@
+#include "RaceLogic.h"
+#include "RaceProfiles.h"
+#include <ncurses.h>
+#include <iostream>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Defined in NcursesGUI.cpp
+void initNcurses();
+void endNcurses();
+void drawRaceTrackGUI(RaceShm* shm, int winner_id);
+void scrollRaceTrackGUI(int delta);
+void setTrackStatusOverride(const string& text);
+
+// ----------------------------------------------------------------------
+// --- RACE TRACE FILE (--record / --replay) ---
+// ----------------------------------------------------------------------
+
+// Racers append every step to their own ring in the segment (see traceStep in
+// RaceLogic.cpp); the monitor drains the rings between frames and appends the
+// steps, merged by time, to a memory-mapped file:
+//
+//   [ TraceFileHeader | records ... ]
+//
+// Every record is a run of LEB128 varints, and all times are deltas from the
+// previous record, so a typical step takes 3-4 bytes:
+//   step:        racer_id << 1,        zigzag(dt_us), zigzag(position delta for that racer)
+//   race start:  TRACE_RACE_START << 1 | 1, zigzag(dt_us), seed   (positions restart at 0)
+//   status:      TRACE_STATUS << 1 | 1,     zigzag(dt_us), status
+// data_bytes in the header is kept current after every drain, so a recording cut
+// short by a crash is still readable up to the last drain.
+
+const char TRACE_MAGIC[8] = {'R', 'A', 'C', 'E', 'T', 'R', 'C', '\0'};
+const uint32_t TRACE_VERSION = 1;
+
+struct TraceFileHeader {
+    char magic[8];        // TRACE_MAGIC
+    uint32_t version;     // TRACE_VERSION
+    int32_t num_racers;
+    int32_t race_length;
+    int32_t reserved;
+    uint64_t data_bytes;  // Valid record bytes after the header
+    uint64_t steps;       // Step records
+    uint64_t races;       // Race start records
+    uint64_t dropped;     // Steps lost to full rings (monitor fell behind)
+    int64_t start_us;     // monotonic_us() the first record's delta is taken from
+};
+
+static_assert(sizeof(TraceFileHeader) == 64, "TraceFileHeader layout is part of the file format");
+
+enum TraceRecordKind {
+    TRACE_RACE_START = 0,
+    TRACE_STATUS = 1,
+    TRACE_STEP = 2 // Not stored: steps are the records with an even key
+};
+
+const size_t TRACE_INITIAL_BYTES = 1 << 20;
+const size_t TRACE_MAX_RECORD_BYTES = 32; // Three varints
+
+// ----------------------------------------------------------------------
+// --- RECORDER (MONITOR SIDE) ---
+// ----------------------------------------------------------------------
+
+struct TraceStep {
+    long t_us;
+    int racer_id;
+    int position;
+};
+
+struct TraceWriter {
+    int fd = -1;
+    string path;
+    char* map = nullptr;
+    size_t capacity = 0;       // Current file (and mapping) size
+    size_t used = 0;           // Header plus records written
+    long last_t_us = 0;
+    bool race_open = false;    // A race start has been written for `seed`
+    uint64_t seed = 0;
+    int status = -1;
+    vector<int> positions;     // Last recorded position per racer
+    vector<TraceStep> batch;   // Steps drained in one pass, sorted by time before writing
+};
+static TraceWriter recorder;
+
+static TraceFileHeader* traceHeader() {
+    return reinterpret_cast<TraceFileHeader*>(recorder.map);
+}
+
+/**
+ * @brief Creates the trace file and maps its first megabyte.
+ */
+bool openTraceRecorder(const string& path) {
+    recorder.fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (recorder.fd == -1) {
+        cerr << "Error: Could not create trace '" << path << "': " << strerror(errno) << endl;
+        return false;
+    }
+    if (ftruncate(recorder.fd, TRACE_INITIAL_BYTES) == -1) {
+        perror("ftruncate (trace) failed");
+        close(recorder.fd);
+        recorder.fd = -1;
+        return false;
+    }
+    void* map = mmap(nullptr, TRACE_INITIAL_BYTES, PROT_READ | PROT_WRITE, MAP_SHARED, recorder.fd, 0);
+    if (map == MAP_FAILED) {
+        perror("mmap (trace) failed");
+        close(recorder.fd);
+        recorder.fd = -1;
+        return false;
+    }
+
+    recorder.path = path;
+    recorder.map = static_cast<char*>(map);
+    recorder.capacity = TRACE_INITIAL_BYTES;
+    recorder.used = sizeof(TraceFileHeader);
+    recorder.last_t_us = monotonic_us();
+    recorder.positions.assign(NUM_RACERS, 0);
+
+    TraceFileHeader* header = traceHeader();
+    memcpy(header->magic, TRACE_MAGIC, sizeof(header->magic));
+    header->version = TRACE_VERSION;
+    header->num_racers = NUM_RACERS;
+    header->race_length = RACE_LENGTH;
+    header->start_us = recorder.last_t_us;
+    return true;
+}
+
+/**
+ * @brief Makes room for one more record, doubling the file (and remapping it) when full.
+ */
+static bool reserveTrace(size_t bytes) {
+    if (recorder.used + bytes <= recorder.capacity) return true;
+
+    size_t capacity = recorder.capacity * 2;
+    if (ftruncate(recorder.fd, capacity) == -1) {
+        perror("ftruncate (trace) failed");
+        return false;
+    }
+    void* map = mremap(recorder.map, recorder.capacity, capacity, MREMAP_MAYMOVE);
+    if (map == MAP_FAILED) {
+        perror("mremap (trace) failed");
+        return false;
+    }
+    recorder.map = static_cast<char*>(map);
+    recorder.capacity = capacity;
+    return true;
+}
+
+static void putVarint(uint64_t value) {
+    while (value >= 0x80) {
+        recorder.map[recorder.used++] = (char)(value | 0x80);
+        value >>= 7;
+    }
+    recorder.map[recorder.used++] = (char)value;
+}
+
+static uint64_t zigzag(int64_t value) {
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static bool writeRecord(uint64_t key, long t_us, uint64_t value) {
+    if (!reserveTrace(TRACE_MAX_RECORD_BYTES)) return false;
+    putVarint(key);
+    putVarint(zigzag(t_us - recorder.last_t_us));
+    putVarint(value);
+    recorder.last_t_us = t_us;
+    return true;
+}
+
+/**
+ * @brief Moves every pending step from the racers' rings into the trace file. Also
+ *        records race starts (seed changes) and status changes. Called by the monitor
+ *        between frames and before each race reset; does nothing unless recording.
+ */
+void drainRaceTrace(RaceShm* shm) {
+    if (recorder.fd == -1 || shm->trace_ring_size == 0) return;
+
+    int size = shm->trace_ring_size;
+    recorder.batch.clear();
+    for (int i = 0; i < NUM_RACERS; ++i) {
+        TraceRing* ring = traceRing(shm, i);
+        uint32_t tail = ring->tail;
+        uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        for (; tail != head; ++tail) {
+            const TraceEvent& event = traceEvents(ring)[tail & (size - 1)];
+            recorder.batch.push_back({event.t_us, i + 1, event.position});
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+    // Each ring is in order; merge them so the file is (almost) monotonic in time
+    stable_sort(recorder.batch.begin(), recorder.batch.end(),
+                [](const TraceStep& a, const TraceStep& b) { return a.t_us < b.t_us; });
+
+    bool ok = true;
+    int status = getRaceStatus(shm);
+    long status_us = __atomic_load_n(&shm->status_changed_us, __ATOMIC_RELAXED);
+
+    // A race is opened once it is under way (or has steps), so an idle READY screen and
+    // the teardown/reset around each race leave no empty races behind
+    bool new_race = !recorder.race_open || shm->race_seed != recorder.seed;
+    if (new_race && recorder.batch.empty() && status != RUNNING && status != PAUSED) return;
+
+    if (new_race) {
+        long start_us = status_us;
+        if (!recorder.batch.empty() && recorder.batch.front().t_us < start_us) start_us = recorder.batch.front().t_us;
+        ok = writeRecord(TRACE_RACE_START << 1 | 1, start_us, shm->race_seed);
+        recorder.race_open = true;
+        recorder.seed = shm->race_seed;
+        recorder.status = -1;
+        recorder.positions.assign(NUM_RACERS, 0);
+        traceHeader()->races++;
+    }
+
+    // The status change goes in at its own time, between the steps around it
+    bool status_pending = ok && status != recorder.status;
+    for (const TraceStep& step : recorder.batch) {
+        if (!ok) break;
+        if (status_pending && status_us <= step.t_us) {
+            ok = writeRecord(TRACE_STATUS << 1 | 1, status_us, (uint64_t)status);
+            status_pending = false;
+        }
+        int& last = recorder.positions[step.racer_id - 1];
+        ok = ok && writeRecord((uint64_t)step.racer_id << 1, step.t_us, zigzag(step.position - last));
+        last = step.position;
+        traceHeader()->steps++;
+    }
+    if (status_pending && ok) {
+        ok = writeRecord(TRACE_STATUS << 1 | 1, status_us, (uint64_t)status);
+    }
+    recorder.status = status;
+
+    traceHeader()->data_bytes = recorder.used - sizeof(TraceFileHeader);
+    if (!ok) {
+        cerr << "Error: trace '" << recorder.path << "' could not grow; recording stopped." << endl;
+        closeTraceRecorder(nullptr);
+    }
+}
+
+/**
+ * @brief Final drain, trims the file to its contents and prints a summary.
+ *        `shm` may be nullptr (recording aborted), then nothing more is drained.
+ */
+void closeTraceRecorder(RaceShm* shm) {
+    if (recorder.fd == -1) return;
+
+    uint64_t dropped = 0;
+    if (shm != nullptr && shm->trace_ring_size != 0) {
+        drainRaceTrace(shm);
+        if (recorder.fd == -1) return; // The final drain failed and closed the recorder
+        for (int i = 0; i < NUM_RACERS; ++i) {
+            dropped += traceRing(shm, i)->dropped;
+        }
+    }
+
+    TraceFileHeader* header = traceHeader();
+    header->dropped = dropped;
+    header->data_bytes = recorder.used - sizeof(TraceFileHeader);
+    uint64_t steps = header->steps;
+    uint64_t races = header->races;
+
+    munmap(recorder.map, recorder.capacity);
+    if (ftruncate(recorder.fd, recorder.used) == -1) {
+        perror("ftruncate (trace) failed");
+    }
+    close(recorder.fd);
+    recorder.fd = -1;
+    recorder.map = nullptr;
+
+    cout << "Trace: " << races << " race(s), " << steps << " steps, " << recorder.used << " bytes";
+    if (steps > 0) printf(" (%.1f bytes/step)", (double)(recorder.used - sizeof(TraceFileHeader)) / steps);
+    if (dropped > 0) cout << ", " << dropped << " steps dropped (monitor fell behind)";
+    cout << " -> " << recorder.path << "\n";
+}
+
+// ----------------------------------------------------------------------
+// --- REPLAY ---
+// ----------------------------------------------------------------------
+
+struct TraceRecord {
+    int kind;       // TraceRecordKind
+    int racer_id;   // TRACE_STEP only
+    long t_us;      // Absolute (start_us plus the deltas so far)
+    int64_t value;  // Position, seed or status
+};
+
+struct TraceReader {
+    const unsigned char* pos;
+    const unsigned char* end;
+    long t_us;
+    vector<int> positions;
+};
+
+static bool getVarint(TraceReader& reader, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && reader.pos < reader.end; shift += 7) {
+        unsigned char byte = *reader.pos++;
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+static int64_t unzigzag(uint64_t value) {
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/**
+ * @brief Decodes the next record. Returns false at the end of the data (or on a
+ *        truncated / corrupt record). The file is untrusted: racer ids, positions
+ *        (0 to RACE_LENGTH plus the largest step) and statuses are range-checked here.
+ */
+static bool nextRecord(TraceReader& reader, TraceRecord& record) {
+    uint64_t key, dt, value;
+    if (!getVarint(reader, key) || !getVarint(reader, dt) || !getVarint(reader, value)) return false;
+
+    reader.t_us += unzigzag(dt);
+    record.t_us = reader.t_us;
+    if ((key & 1) == 0) {
+        int racer_id = (int)(key >> 1);
+        if (racer_id < 1 || racer_id > (int)reader.positions.size()) return false;
+        record.kind = TRACE_STEP;
+        record.racer_id = racer_id;
+        int64_t position = reader.positions[racer_id - 1] + unzigzag(value);
+        if (position < 0 || position > RACE_LENGTH + PROFILE_MAX_STEP) return false;
+        reader.positions[racer_id - 1] = (int)position;
+        record.value = position;
+    } else {
+        record.kind = (int)(key >> 1);
+        record.racer_id = 0;
+        record.value = (int64_t)value;
+        if (record.kind == TRACE_STATUS && value > (uint64_t)EXITING) return false;
+        if (record.kind == TRACE_RACE_START) reader.positions.assign(reader.positions.size(), 0);
+    }
+    return true;
+}
+
+/**
+ * @brief Applies one record to the replay arena, the way the racers and monitor
+ *        would have changed it live.
+ */
+static void applyRecord(RaceShm* shm, const TraceRecord& record) {
+    if (record.kind == TRACE_RACE_START) {
+        resetRaceState(shm);
+        shm->race_seed = (uint64_t)record.value;
+        setRaceStatus(shm, READY);
+    } else if (record.kind == TRACE_STATUS) {
+        if (record.value != EXITING) setRaceStatus(shm, (int)record.value);
+    } else if (record.kind == TRACE_STEP) {
+        RacerSlot* slot = racerSlot(shm, record.racer_id - 1);
+        int position = (int)record.value;
+        bool finished = position >= RACE_LENGTH && slot->position < RACE_LENGTH;
+        racerSlotWriteBegin(slot);
+        __atomic_store_n(&slot->steps, slot->steps + 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&slot->last_step_us, monotonic_us(), __ATOMIC_RELAXED);
+        if (finished) __atomic_store_n(&slot->finish_time_ms, record.t_us / 1000, __ATOMIC_RELAXED);
+        __atomic_store_n(&slot->position, position, __ATOMIC_RELAXED);
+        racerSlotWriteEnd(slot);
+        if (finished && shm->finish_count < NUM_RACERS) { // A corrupt trace can cross the line twice
+            finishOrder(shm)[shm->finish_count] = record.racer_id;
+            __atomic_store_n(&shm->finish_count, shm->finish_count + 1, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+/**
+ * @brief --replay with --headless: one line per race, no timing.
+ */
+static void printReplaySummary(RaceShm* shm, TraceReader& reader, const TraceFileHeader& header) {
+    printf("Trace %s: %d racers, length %d, %llu races, %llu steps (%.1f bytes/step), %llu dropped\n",
+           REPLAY_PATH.c_str(), header.num_racers, header.race_length, (unsigned long long)header.races,
+           (unsigned long long)header.steps,
+           header.steps ? (double)header.data_bytes / header.steps : 0.0, (unsigned long long)header.dropped);
+
+    int race = 0;
+    long running_us = 0;
+    auto printRace = [&]() {
+        if (race == 0 || race > 20) return;
+        int winner = shm->finish_count > 0 ? finishOrder(shm)[0] : 0;
+        printf("  Race %-4d seed %-20llu ", race, (unsigned long long)shm->race_seed);
+        if (winner == 0) {
+            printf("no finisher\n");
+            return;
+        }
+        long winner_us = racerSlot(shm, winner - 1)->finish_time_ms * 1000;
+        printf("winner Racer %-4d %8.1f ms  order", winner, running_us ? (winner_us - running_us) / 1000.0 : 0.0);
+        for (int i = 0; i < shm->finish_count && i < 8; ++i) printf(" %d", finishOrder(shm)[i]);
+        printf("%s\n", shm->finish_count > 8 ? " ..." : "");
+    };
+
+    TraceRecord record;
+    while (nextRecord(reader, record)) {
+        if (record.kind == TRACE_RACE_START) {
+            printRace();
+            race++;
+            running_us = 0;
+        } else if (record.kind == TRACE_STATUS && record.value == RUNNING && running_us == 0) {
+            running_us = record.t_us;
+        }
+        applyRecord(shm, record);
+    }
+    printRace();
+    if (race > 20) printf("  ... (%d races in total)\n", race);
+}
+
+/**
+ * @brief Plays the trace back through drawRaceTrackGUI() at REPLAY_SPEED. Idle gaps
+ *        longer than REPLAY_MAX_GAP_US (e.g. between races) are shortened.
+ */
+static void playReplay(RaceShm* shm, TraceReader& reader, const TraceFileHeader& header) {
+    const long REPLAY_MAX_GAP_US = 2000000;
+    double speed = REPLAY_SPEED;
+
+    initNcurses();
+
+    TraceRecord record;
+    bool have_record = nextRecord(reader, record);
+    long trace_base_us = have_record ? record.t_us : 0; // Trace time shown at wall_base_us
+    long wall_base_us = monotonic_us();
+    long last_trace_us = trace_base_us;
+    bool paused = false;
+    long paused_at_us = 0;
+    int race = 0;
+
+    while (true) {
+        int ch;
+        bool quit = false;
+        while ((ch = getch()) != ERR) {
+            long now_us = monotonic_us();
+            if (ch == 'q' || ch == 'Q') {
+                quit = true;
+            } else if (ch == 'p' || ch == 'P' || ch == ' ') {
+                paused = !paused;
+                if (paused) paused_at_us = now_us;
+                else wall_base_us += now_us - paused_at_us;
+            } else if ((ch == '+' || ch == '-') && !paused) {
+                // Keep the current trace time where it is and change the rate from here
+                long trace_now_us = trace_base_us + (long)((now_us - wall_base_us) * speed);
+                speed = ch == '+' ? min(speed * 2, 1000.0) : max(speed / 2, 0.01);
+                trace_base_us = trace_now_us;
+                wall_base_us = now_us;
+            } else if (ch == KEY_UP || ch == KEY_DOWN) {
+                scrollRaceTrackGUI(ch == KEY_UP ? -1 : 1);
+            }
+        }
+        if (quit) break;
+
+        // Apply every record that is due
+        long now_us = monotonic_us();
+        long trace_now_us = trace_base_us + (long)(((paused ? paused_at_us : now_us) - wall_base_us) * speed);
+        while (have_record && record.t_us <= trace_now_us) {
+            if (record.kind == TRACE_RACE_START) race++;
+            applyRecord(shm, record);
+            last_trace_us = record.t_us;
+            have_record = nextRecord(reader, record);
+            if (have_record && record.t_us - last_trace_us > REPLAY_MAX_GAP_US) {
+                trace_base_us += record.t_us - last_trace_us - REPLAY_MAX_GAP_US;
+            }
+        }
+
+        char note[128];
+        if (!have_record) {
+            snprintf(note, sizeof(note), "REPLAY FINISHED (%d of %llu races). Press 'Q' to exit.",
+                     race, (unsigned long long)header.races);
+        } else {
+            snprintf(note, sizeof(note), "REPLAY%s x%g: race %d of %llu. P: pause, +/-: speed, Q: exit.",
+                     paused ? " PAUSED" : "", speed, race, (unsigned long long)header.races);
+        }
+        setTrackStatusOverride(note);
+        drawRaceTrackGUI(shm, shm->finish_count > 0 ? finishOrder(shm)[0] : 0);
+
+        // Sleep until the next record is due (at most one frame), waking early for keys
+        long wait_ms = 50;
+        if (have_record && !paused) {
+            long due_ms = (long)((record.t_us - trace_base_us) / speed + wall_base_us - monotonic_us()) / 1000;
+            wait_ms = max(0L, min(wait_ms, due_ms));
+        }
+        struct pollfd input = {STDIN_FILENO, POLLIN, 0};
+        poll(&input, 1, (int)wait_ms);
+    }
+
+    setTrackStatusOverride("");
+    endNcurses();
+}
+
+/**
+ * @brief --replay FILE: maps the trace, sizes an in-process arena from its header and
+ *        plays it back (TUI) or summarizes it (--headless).
+ * @return Process exit code.
+ */
+int runReplay() {
+    int fd = open(REPLAY_PATH.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        cerr << "Error: Could not open trace '" << REPLAY_PATH << "': " << strerror(errno) << endl;
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || (size_t)st.st_size < sizeof(TraceFileHeader)) {
+        cerr << "Error: '" << REPLAY_PATH << "' is not a race trace." << endl;
+        close(fd);
+        return 1;
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap (trace) failed");
+        return 1;
+    }
+
+    const TraceFileHeader* header = static_cast<const TraceFileHeader*>(map);
+    if (memcmp(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header->version != TRACE_VERSION ||
+        header->num_racers < 1 || header->num_racers > MAX_RACERS ||
+        header->race_length < 1 || header->race_length > MAX_RACE_LENGTH ||
+        header->data_bytes > (uint64_t)st.st_size - sizeof(TraceFileHeader)) {
+        cerr << "Error: '" << REPLAY_PATH << "' is not a race trace (or has an unsupported version)." << endl;
+        munmap(map, st.st_size);
+        return 1;
+    }
+
+    // The replay arena is a plain in-process one, shaped like the recorded race
+    NUM_RACERS = header->num_racers;
+    RACE_LENGTH = header->race_length;
+    RACE_BACKEND = BACKEND_THREAD;
+    computeShmLayout();
+    RaceShm* shm = createRaceArena();
+    if (shm == nullptr) {
+        munmap(map, st.st_size);
+        return 1;
+    }
+
+    TraceReader reader;
+    reader.pos = static_cast<const unsigned char*>(map) + sizeof(TraceFileHeader);
+    reader.end = reader.pos + header->data_bytes;
+    reader.t_us = header->start_us;
+    reader.positions.assign(NUM_RACERS, 0);
+
+    if (HEADLESS) {
+        printReplaySummary(shm, reader, *header);
+    } else {
+        playReplay(shm, reader, *header);
+    }
+
+    destroyRaceArena(shm);
+    munmap(map, st.st_size);
+    return 0;
+}
@@ -0,0 +1,385 @@
+#include "RaceLogic.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+using namespace std;
+
+// ----------------------------------------------------------------------
+// --- RESULTS ANALYTICS ---
+// ----------------------------------------------------------------------
+
+// Whole-history statistics over race_results.rlog: win rate, podiums and
+// streaks per racer, and the mean, spread and quantiles of the winning time.
+// Nothing here rescans the log:
+//   - every logged result is folded into running aggregates (Welford mean and
+//     variance, a log-bucketed quantile sketch, per-racer counters)
+//   - on every log flush the aggregates are saved to race_results.stats, along
+//     with the log offset and race count they cover
+//   - loading reads race_results.stats and folds in only the records appended
+//     after that offset; a missing or mismatched file is rebuilt from the log once
+//
+// race_results.stats: AnalyticsFileHeader | sketch[SKETCH_BUCKETS] | RacerTotals[num_racers]
+
+const char* RESULTS_STATS_FILE = "race_results.stats";
+
+const uint32_t ANALYTICS_FILE_MAGIC = 0x41545352; // "RSTA"
+const uint32_t ANALYTICS_FILE_VERSION = 1;
+
+// Quantile sketch: bucket 0 counts 0 ms, bucket b >= 1 counts (gamma^(b-2), gamma^(b-1)] ms.
+// Reporting each bucket's midpoint keeps every quantile within SKETCH_ACCURACY of the
+// true value, with a fixed size no matter how many races are added.
+const double SKETCH_ACCURACY = 0.01;
+const double SKETCH_GAMMA = (1.0 + SKETCH_ACCURACY) / (1.0 - SKETCH_ACCURACY);
+const int SKETCH_BUCKETS = 1280; // Up to gamma^1278 ms (~3 years); longer lands in the last bucket
+
+struct AnalyticsFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    int64_t log_offset;       // Log bytes folded in (0 = none), always a record boundary
+    int64_t races;            // Records folded in: the log footer's race count at log_offset
+    int64_t timed_races;      // Races with a winner (count of the duration statistics)
+    double duration_mean_ms;  // Welford running mean and sum of squared deviations
+    double duration_m2;
+    int64_t duration_min_ms;
+    int64_t duration_max_ms;
+    int32_t last_winner;      // Winner of the latest race (0 = none); holds the current streak
+    int32_t num_racers;       // RacerTotals entries after the sketch
+    int32_t sketch_buckets;   // SKETCH_BUCKETS
+    int32_t reserved;
+};
+
+struct RacerTotals {
+    int64_t starts;
+    int64_t wins;
+    int64_t podiums;
+    int64_t current_streak;
+    int64_t best_streak;
+    int64_t finishes;         // Welford over this racer's finish times
+    double finish_mean_ms;
+    double finish_m2;
+};
+
+static AnalyticsFileHeader totals;
+static vector<uint64_t> sketch(SKETCH_BUCKETS);
+static vector<RacerTotals> racers; // Indexed by racer id - 1
+
+static bool analytics_loaded = false;
+static uint64_t analytics_version = 0; // Bumped on every change (snapshot cache key)
+static int64_t last_caught_up = 0;
+static bool last_rebuilt = false;
+
+// ----------------------------------------------------------------------
+// --- AGGREGATES ---
+// ----------------------------------------------------------------------
+
+static void resetAnalytics() {
+    totals = AnalyticsFileHeader{};
+    sketch.assign(SKETCH_BUCKETS, 0);
+    racers.clear();
+}
+
+static int sketchBucket(int64_t ms) {
+    if (ms <= 0) return 0;
+    int bucket = 1 + (int)ceil(log((double)ms) / log(SKETCH_GAMMA));
+    return bucket < SKETCH_BUCKETS ? bucket : SKETCH_BUCKETS - 1;
+}
+
+/**
+ * @brief Winning time at quantile q (0-1), from the sketch.
+ */
+static double sketchQuantile(double q) {
+    if (totals.timed_races == 0) return 0;
+    uint64_t rank = (uint64_t)(q * (totals.timed_races - 1)) + 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < SKETCH_BUCKETS; ++b) {
+        seen += sketch[b];
+        if (seen < rank) continue;
+        double value = b == 0 ? 0.0 : 2.0 * pow(SKETCH_GAMMA, b - 1) / (SKETCH_GAMMA + 1.0);
+        return min(max(value, (double)totals.duration_min_ms), (double)totals.duration_max_ms);
+    }
+    return (double)totals.duration_max_ms;
+}
+
+static void addSample(int64_t& count, double& mean, double& m2, double value) {
+    count++;
+    double delta = value - mean;
+    mean += delta / count;
+    m2 += delta * (value - mean);
+}
+
+static double stddev(int64_t count, double m2) {
+    return count > 1 ? sqrt(m2 / (count - 1)) : 0.0;
+}
+
+/**
+ * @brief Adds one race to the aggregates. O(field size), independent of the history.
+ */
+static void foldResult(const RaceResult& result) {
+    totals.races++;
+
+    // steps lists the whole field; results imported from race_results.txt only name
+    // the winner, so their field is taken to be racers 1..winner
+    size_t field = result.steps.size();
+    for (int id : result.finish_order) field = max(field, (size_t)max(id, 0));
+    if (racers.size() < field) racers.resize(field, RacerTotals{});
+    for (size_t i = 0; i < field; ++i) racers[i].starts++;
+
+    int winner = result.winner;
+    if (winner > 0 && (size_t)winner <= racers.size()) {
+        if (totals.timed_races == 0 || result.duration_ms < totals.duration_min_ms) totals.duration_min_ms = result.duration_ms;
+        if (totals.timed_races == 0 || result.duration_ms > totals.duration_max_ms) totals.duration_max_ms = result.duration_ms;
+        addSample(totals.timed_races, totals.duration_mean_ms, totals.duration_m2, (double)result.duration_ms);
+        sketch[sketchBucket(result.duration_ms)]++;
+
+        RacerTotals& r = racers[winner - 1];
+        r.wins++;
+        if (totals.last_winner != winner) {
+            if (totals.last_winner > 0) racers[totals.last_winner - 1].current_streak = 0;
+            r.current_streak = 0;
+        }
+        r.current_streak++;
+        r.best_streak = max(r.best_streak, r.current_streak);
+        totals.last_winner = winner;
+    } else if (totals.last_winner > 0) {
+        racers[totals.last_winner - 1].current_streak = 0;
+        totals.last_winner = 0;
+    }
+
+    for (size_t place = 0; place < result.finish_order.size(); ++place) {
+        int id = result.finish_order[place];
+        if (id <= 0) continue;
+        RacerTotals& r = racers[id - 1];
+        if (place < 3) r.podiums++;
+        if (place < result.finish_ms.size()) addSample(r.finishes, r.finish_mean_ms, r.finish_m2, (double)result.finish_ms[place]);
+    }
+    analytics_version++;
+}
+
+// ----------------------------------------------------------------------
+// --- race_results.stats ---
+// ----------------------------------------------------------------------
+
+static bool readAnalyticsFile() {
+    int fd = open(RESULTS_STATS_FILE, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+
+    AnalyticsFileHeader header;
+    struct stat st;
+    bool ok = pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) && fstat(fd, &st) == 0 &&
+              header.magic == ANALYTICS_FILE_MAGIC && header.version == ANALYTICS_FILE_VERSION &&
+              header.sketch_buckets == SKETCH_BUCKETS && header.num_racers >= 0 && header.num_racers <= MAX_RACERS &&
+              header.last_winner >= 0 && header.last_winner <= header.num_racers &&
+              st.st_size == (off_t)(sizeof(header) + sizeof(uint64_t) * SKETCH_BUCKETS + sizeof(RacerTotals) * header.num_racers);
+    if (ok) {
+        racers.assign(header.num_racers, RacerTotals{});
+        size_t sketch_bytes = sizeof(uint64_t) * SKETCH_BUCKETS;
+        size_t racer_bytes = sizeof(RacerTotals) * racers.size();
+        ok = pread(fd, sketch.data(), sketch_bytes, sizeof(header)) == (ssize_t)sketch_bytes &&
+             pread(fd, racers.data(), racer_bytes, sizeof(header) + sketch_bytes) == (ssize_t)racer_bytes;
+        totals = header;
+    }
+    close(fd);
+    return ok;
+}
+
+/**
+ * @brief Replaces race_results.stats with the current aggregates (write + rename, so a
+ *        reader never sees a half-written file).
+ */
+static void saveAnalyticsFile() {
+    string tmp = string(RESULTS_STATS_FILE) + "." + to_string(getpid()) + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        perror("Could not write race_results.stats");
+        return;
+    }
+
+    totals.magic = ANALYTICS_FILE_MAGIC;
+    totals.version = ANALYTICS_FILE_VERSION;
+    totals.num_racers = (int32_t)racers.size();
+    totals.sketch_buckets = SKETCH_BUCKETS;
+
+    struct iovec parts[3] = {
+        {&totals, sizeof(totals)},
+        {sketch.data(), sizeof(uint64_t) * sketch.size()},
+        {racers.data(), sizeof(RacerTotals) * racers.size()},
+    };
+    ssize_t expected = (ssize_t)(parts[0].iov_len + parts[1].iov_len + parts[2].iov_len);
+    bool ok = writev(fd, parts, 3) == expected;
+    close(fd);
+
+    if (!ok || rename(tmp.c_str(), RESULTS_STATS_FILE) != 0) {
+        perror("Could not write race_results.stats");
+        unlink(tmp.c_str());
+    }
+}
+
+// ----------------------------------------------------------------------
+// --- SYNCING WITH THE LOG ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief Brings the analytics up to date with race_results.rlog. The first call loads
+ *        race_results.stats; later calls only fold in records other processes appended.
+ * @return false if there is no results log.
+ */
+bool syncResultsAnalytics() {
+    struct stat st;
+    if (stat(RESULTS_LOG_FILE, &st) != 0) {
+        analytics_loaded = false;
+        return false;
+    }
+    if (analytics_loaded && st.st_size == totals.log_offset) return true;
+    if (analytics_loaded && st.st_size < totals.log_offset) analytics_loaded = false; // Log truncated or replaced
+
+    bool loading = !analytics_loaded;
+    if (loading) {
+        last_caught_up = 0;
+        last_rebuilt = false;
+        // The saved offset must still end the record that makes it races long
+        if (!readAnalyticsFile() || resultsLogRacesAt(totals.log_offset) != totals.races) {
+            resetAnalytics();
+            last_rebuilt = true;
+        }
+        analytics_version++;
+    }
+
+    int64_t races_before = totals.races;
+    off_t end = readResultsFrom(totals.log_offset, foldResult);
+    if (end < 0) {
+        analytics_loaded = false;
+        return false;
+    }
+    totals.log_offset = end;
+    last_caught_up += totals.races - races_before;
+
+    // Saved only when nothing is buffered: on load (the log was just flushed) and after
+    // a flush, so the file's race count always matches its log offset
+    if (loading) {
+        analytics_loaded = true;
+        if (last_rebuilt || totals.races != races_before) saveAnalyticsFile();
+    }
+    return true;
+}
+
+/**
+ * @brief logRaceResult() hook: the result counts from now on, before it is flushed.
+ */
+void foldIntoResultsAnalytics(const RaceResult& result) {
+    if (analytics_loaded) foldResult(result);
+}
+
+/**
+ * @brief flushResultsLog() hook: our buffered records moved the log from `before` to
+ *        `after` bytes. If another writer appended in between, our aggregates no longer
+ *        describe a prefix of the log and are reloaded on next use.
+ */
+void resultsAnalyticsFlushed(off_t before, off_t after) {
+    if (!analytics_loaded) return;
+    if (before != totals.log_offset) {
+        analytics_loaded = false;
+        return;
+    }
+    totals.log_offset = after;
+    saveAnalyticsFile();
+}
+
+/**
+ * @brief Current analytics with the max_racers racers that won most. `out` is left as it
+ *        is if nothing changed since it was filled, so callers can poll every frame.
+ * @return false if there is no results log.
+ */
+bool resultsAnalyticsSnapshot(ResultsAnalytics& out, size_t max_racers) {
+    if (!analytics_loaded) flushResultsLog(); // Our buffered records must be in the log first
+    if (!syncResultsAnalytics()) return false;
+    if (out.version == analytics_version && out.racer_limit == max_racers) return true;
+
+    out.version = analytics_version;
+    out.racer_limit = max_racers;
+    out.races = totals.races;
+    out.timed_races = totals.timed_races;
+    out.mean_ms = totals.duration_mean_ms;
+    out.sd_ms = stddev(totals.timed_races, totals.duration_m2);
+    out.min_ms = totals.duration_min_ms;
+    out.max_ms = totals.duration_max_ms;
+    out.p50_ms = sketchQuantile(0.50);
+    out.p90_ms = sketchQuantile(0.90);
+    out.p95_ms = sketchQuantile(0.95);
+    out.p99_ms = sketchQuantile(0.99);
+    out.streak_racer = totals.last_winner;
+    out.streak = totals.last_winner > 0 ? racers[totals.last_winner - 1].current_streak : 0;
+    out.caught_up = last_caught_up;
+    out.rebuilt = last_rebuilt;
+
+    out.best_streak_racer = 0;
+    out.best_streak = 0;
+    vector<int> ranking;
+    for (size_t i = 0; i < racers.size(); ++i) {
+        if (racers[i].best_streak > out.best_streak) {
+            out.best_streak = racers[i].best_streak;
+            out.best_streak_racer = (int)i + 1;
+        }
+        if (racers[i].starts > 0) ranking.push_back((int)i + 1);
+    }
+    size_t shown = min(max_racers, ranking.size());
+    partial_sort(ranking.begin(), ranking.begin() + shown, ranking.end(), [](int a, int b) {
+        return racers[a - 1].wins != racers[b - 1].wins ? racers[a - 1].wins > racers[b - 1].wins : a < b;
+    });
+
+    out.racers.clear();
+    for (size_t i = 0; i < shown; ++i) {
+        const RacerTotals& r = racers[ranking[i] - 1];
+        out.racers.push_back({ranking[i], r.starts, r.wins, r.podiums, r.current_streak, r.best_streak,
+                              r.finishes, r.finish_mean_ms, stddev(r.finishes, r.finish_m2)});
+    }
+    return true;
+}
+
+/**
+ * @brief Prints the whole-history analytics (--analytics).
+ */
+void printResultsAnalytics() {
+    auto begin = chrono::steady_clock::now();
+    ResultsAnalytics a;
+    if (!resultsAnalyticsSnapshot(a, 20)) {
+        cerr << "No results log found (" << RESULTS_LOG_FILE << ")." << endl;
+        return;
+    }
+    double load_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+
+    if (a.rebuilt) {
+        printf("Built %s from %lld logged races in %.2f ms\n", RESULTS_STATS_FILE, (long long)a.races, load_ms);
+    } else {
+        printf("Loaded %s in %.2f ms (%lld new races folded in from the log)\n", RESULTS_STATS_FILE, load_ms,
+               (long long)a.caught_up);
+    }
+    printf("Races: %lld (%lld with a winner)\n", (long long)a.races, (long long)a.timed_races);
+    if (a.timed_races == 0) return;
+
+    printf("Winning time: mean %.3fs | sd %.3fs | min %.3fs | p50 %.3fs | p90 %.3fs | p95 %.3fs | p99 %.3fs | max %.3fs\n",
+           a.mean_ms / 1000.0, a.sd_ms / 1000.0, a.min_ms / 1000.0, a.p50_ms / 1000.0, a.p90_ms / 1000.0,
+           a.p95_ms / 1000.0, a.p99_ms / 1000.0, a.max_ms / 1000.0);
+    if (a.streak_racer > 0) {
+        printf("Current streak: Racer %d, %lld win(s)", a.streak_racer, (long long)a.streak);
+    } else {
+        printf("Current streak: none");
+    }
+    printf(" | Longest streak: Racer %d, %lld wins\n", a.best_streak_racer, (long long)a.best_streak);
+
+    printf("%-12s %10s %10s %7s %10s %14s %9s %8s\n", "RACER", "STARTS", "WINS", "WIN%", "PODIUMS",
+           "MEAN FINISH", "SD", "BEST RUN");
+    for (const RacerAnalytics& r : a.racers) {
+        printf("Racer %-6d %10lld %10lld %6.1f%% %10lld %13.3fs %8.3fs %8lld\n", r.racer_id, (long long)r.starts,
+               (long long)r.wins, r.starts ? 100.0 * r.wins / r.starts : 0.0, (long long)r.podiums,
+               r.finish_mean_ms / 1000.0, r.finish_sd_ms / 1000.0, (long long)r.best_streak);
+    }
+}
@@ -0,0 +1,691 @@
+#include "RaceLogic.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+
+using namespace std;
+
+// ----------------------------------------------------------------------
+// --- RESULTS STORE ---
+// ----------------------------------------------------------------------
+
+// race_results.rlog is an append-only binary log. After a small file header,
+// every race is one self-describing record:
+//
+//   ResultRecordHeader | finish_order[finished] | finish_ms[finished] | steps[num_racers] | ResultRecordFooter
+//
+// The footer repeats the record size (so the file can be walked backwards from
+// EOF) and carries running aggregates over the whole log up to that record.
+// Loading the last N results therefore reads N records from the tail, and the
+// aggregates are a single footer read - neither depends on the file size.
+// Several processes may append: each holds an exclusive flock() while it writes
+// and continues the totals and sequence numbers from the footer that ends the log
+// at that moment, so every footer covers every writer's races.
+//
+// race_results.txt keeps receiving the same human-readable line as before, and
+// race_results.stats holds the whole-history analytics (see ResultsAnalytics.cpp).
+
+const char* RESULTS_LOG_FILE = "race_results.rlog";
+const char* RESULTS_TEXT_FILE = "race_results.txt";
+
+const uint32_t RESULTS_FILE_MAGIC = 0x474c5252;   // "RRLG"
+const uint32_t RESULTS_FILE_VERSION = 3; // v2: race seed in every record; v3: timed_races in footers
+const uint32_t RESULT_RECORD_MAGIC = 0x44524352;  // "RCRD"
+const uint32_t RESULT_FOOTER_MAGIC = 0x544f4f46;  // "FOOT"
+
+// Records are buffered and written with one write() once this much is pending
+const size_t RESULTS_FLUSH_BYTES = 64 * 1024;
+
+struct ResultsFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t reserved;
+};
+
+struct ResultRecordHeader {
+    uint32_t magic;
+    int32_t num_racers;     // Length of the steps array
+    uint64_t sequence;      // 1-based race number within the log
+    int64_t timestamp;      // Unix time the result was logged
+    int64_t start_time_ms;  // Race start, ms since epoch
+    int64_t duration_ms;    // Winner's time
+    int32_t winner;
+    int32_t finished;       // Length of finish_order / finish_ms
+    uint64_t seed;          // Race seed (replay with --seed)
+};
+
+struct ResultRecordFooter {
+    uint32_t record_size;   // Bytes from the start of the header to the end of this footer
+    uint32_t magic;
+    ResultsAggregate totals; // Running aggregates including this record
+};
+
+static int results_fd = -1;
+static ofstream results_text;
+static vector<RaceResult> pending;     // Results not yet written (encoded at flush)
+static size_t pending_bytes = 0;       // Their encoded size
+static ResultsAggregate running_totals; // Aggregates as of the last record we wrote
+static off_t results_end = 0;          // Log size after our last write
+
+// --- Recent results cache (backs the TUI results view) ---
+// A ring of the newest formatted result lines. It is seeded once from the log
+// tail, then kept current incrementally: results logged by this process are
+// pushed directly, and records appended by other processes are picked up by
+// tracking the log's size and decoding only the bytes past recent_synced_offset.
+const size_t RECENT_RESULTS_CAPACITY = 64;
+static vector<string> recent_ring(RECENT_RESULTS_CAPACITY);
+static size_t recent_next = 0;         // Ring slot the next line goes into
+static size_t recent_count = 0;
+static bool recent_loaded = false;
+static off_t recent_synced_offset = 0; // Log bytes already reflected in the ring
+static int recent_fd = -1;             // Read-only handle used to follow the log
+
+// ----------------------------------------------------------------------
+// --- ENCODING ---
+// ----------------------------------------------------------------------
+
+template <typename T>
+static void append(vector<char>& buf, const T& value) {
+    const char* bytes = reinterpret_cast<const char*>(&value);
+    buf.insert(buf.end(), bytes, bytes + sizeof(T));
+}
+
+static void encodeRecord(const RaceResult& result, vector<char>& buf) {
+    size_t record_start = buf.size();
+
+    ResultRecordHeader header = {};
+    header.magic = RESULT_RECORD_MAGIC;
+    header.num_racers = (int32_t)result.steps.size();
+    header.sequence = running_totals.total_races;
+    header.timestamp = result.timestamp;
+    header.start_time_ms = result.start_time_ms;
+    header.duration_ms = result.duration_ms;
+    header.winner = result.winner;
+    header.finished = (int32_t)result.finish_order.size();
+    header.seed = result.seed;
+    append(buf, header);
+
+    for (int id : result.finish_order) append(buf, (int32_t)id);
+    for (long ms : result.finish_ms) append(buf, (int64_t)ms);
+    for (int steps : result.steps) append(buf, (int32_t)steps);
+
+    ResultRecordFooter footer = {};
+    footer.record_size = (uint32_t)(buf.size() - record_start + sizeof(ResultRecordFooter));
+    footer.magic = RESULT_FOOTER_MAGIC;
+    footer.totals = running_totals;
+    append(buf, footer);
+}
+
+/**
+ * @brief Decodes one record. Returns false if the bytes are not a valid record.
+ */
+static bool decodeRecord(const char* data, size_t size, RaceResult& result, ResultsAggregate* totals) {
+    if (size < sizeof(ResultRecordHeader) + sizeof(ResultRecordFooter)) return false;
+
+    ResultRecordHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != RESULT_RECORD_MAGIC || header.finished < 0 || header.num_racers < 0) return false;
+
+    size_t expected = sizeof(header) + header.finished * (sizeof(int32_t) + sizeof(int64_t)) +
+                      header.num_racers * sizeof(int32_t) + sizeof(ResultRecordFooter);
+    if (expected != size) return false;
+
+    const char* p = data + sizeof(header);
+    result.timestamp = header.timestamp;
+    result.start_time_ms = header.start_time_ms;
+    result.duration_ms = header.duration_ms;
+    result.winner = header.winner;
+    result.seed = header.seed;
+    result.finish_order.resize(header.finished);
+    result.finish_ms.resize(header.finished);
+    result.steps.resize(header.num_racers);
+    for (int i = 0; i < header.finished; ++i, p += sizeof(int32_t)) {
+        int32_t id;
+        memcpy(&id, p, sizeof(id));
+        result.finish_order[i] = id;
+    }
+    for (int i = 0; i < header.finished; ++i, p += sizeof(int64_t)) {
+        int64_t ms;
+        memcpy(&ms, p, sizeof(ms));
+        result.finish_ms[i] = ms;
+    }
+    for (int i = 0; i < header.num_racers; ++i, p += sizeof(int32_t)) {
+        int32_t steps;
+        memcpy(&steps, p, sizeof(steps));
+        result.steps[i] = steps;
+    }
+
+    ResultRecordFooter footer;
+    memcpy(&footer, p, sizeof(footer));
+    if (footer.magic != RESULT_FOOTER_MAGIC || footer.record_size != size) return false;
+    if (totals) *totals = footer.totals;
+    return true;
+}
+
+static void addToTotals(ResultsAggregate& totals, const RaceResult& result) {
+    totals.total_races++;
+    if (result.winner <= 0) return; // Every racer DNF: there is no winning time
+
+    if (totals.timed_races == 0 || result.duration_ms < totals.min_duration_ms) {
+        totals.min_duration_ms = result.duration_ms;
+    }
+    if (totals.timed_races == 0 || result.duration_ms > totals.max_duration_ms) {
+        totals.max_duration_ms = result.duration_ms;
+    }
+    totals.timed_races++;
+    totals.total_duration_ms += result.duration_ms;
+}
+
+// ----------------------------------------------------------------------
+// --- READING FROM THE TAIL ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief Reads the record that ends at file offset `end`. Returns its start offset, or -1.
+ */
+static off_t readRecordEndingAt(int fd, off_t end, RaceResult& result, ResultsAggregate* totals) {
+    if (end < (off_t)(sizeof(ResultsFileHeader) + sizeof(ResultRecordFooter))) return -1;
+
+    ResultRecordFooter footer;
+    if (pread(fd, &footer, sizeof(footer), end - sizeof(footer)) != (ssize_t)sizeof(footer)) return -1;
+    if (footer.magic != RESULT_FOOTER_MAGIC || footer.record_size > end - (off_t)sizeof(ResultsFileHeader)) return -1;
+
+    off_t start = end - footer.record_size;
+    vector<char> data(footer.record_size);
+    if (pread(fd, data.data(), data.size(), start) != (ssize_t)data.size()) return -1;
+    if (!decodeRecord(data.data(), data.size(), result, totals)) return -1;
+    return start;
+}
+
+/**
+ * @brief Walks records forward from the file header; returns the end of the last valid one.
+ *        Only used to recover from a torn final write.
+ */
+static off_t findLastValidRecordEnd(int fd, off_t file_size, ResultsAggregate& totals) {
+    off_t offset = sizeof(ResultsFileHeader);
+    totals = ResultsAggregate{};
+    while (offset + (off_t)sizeof(ResultRecordHeader) <= file_size) {
+        ResultRecordHeader header;
+        if (pread(fd, &header, sizeof(header), offset) != (ssize_t)sizeof(header)) break;
+        if (header.magic != RESULT_RECORD_MAGIC || header.finished < 0 || header.num_racers < 0) break;
+
+        off_t size = sizeof(header) + header.finished * (sizeof(int32_t) + sizeof(int64_t)) +
+                     header.num_racers * sizeof(int32_t) + sizeof(ResultRecordFooter);
+        RaceResult result;
+        ResultsAggregate record_totals;
+        if (offset + size > file_size || readRecordEndingAt(fd, offset + size, result, &record_totals) != offset) break;
+        totals = record_totals;
+        offset += size;
+    }
+    return offset;
+}
+
+/**
+ * @brief Number of races in the log as of the record ending at `end` (0 for the empty
+ *        log), or -1 if no record ends there. Checks that a saved log position still
+ *        belongs to this log.
+ */
+int64_t resultsLogRacesAt(off_t end) {
+    if (end == 0 || end == (off_t)sizeof(ResultsFileHeader)) return 0;
+
+    int fd = open(RESULTS_LOG_FILE, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return -1;
+    RaceResult result;
+    ResultsAggregate totals;
+    off_t start = readRecordEndingAt(fd, end, result, &totals);
+    close(fd);
+    return start < 0 ? -1 : totals.total_races;
+}
+
+/**
+ * @brief Passes every complete record from file offset `offset` (0 = the first record)
+ *        to EOF to `visit`, oldest first. Reads in large chunks, so a full pass over a
+ *        long log costs a few syscalls per megabyte.
+ * @return Offset just past the last record visited, or -1 if there is no log.
+ */
+off_t readResultsFrom(off_t offset, void (*visit)(const RaceResult&)) {
+    int fd = open(RESULTS_LOG_FILE, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return -1;
+
+    const size_t READ_CHUNK = 1 << 20;
+    off_t file_size = lseek(fd, 0, SEEK_END);
+    off_t pos = offset > (off_t)sizeof(ResultsFileHeader) ? offset : (off_t)sizeof(ResultsFileHeader);
+    vector<char> buf;
+    off_t buf_start = pos;
+
+    // Makes [pos, pos + n) available in buf, refilling it from pos when needed
+    auto ensure = [&](size_t n) {
+        if (pos >= buf_start && pos + (off_t)n <= buf_start + (off_t)buf.size()) return true;
+        size_t want = max(n, (size_t)min((off_t)READ_CHUNK, file_size - pos));
+        buf.resize(want);
+        buf_start = pos;
+        return pread(fd, buf.data(), want, pos) == (ssize_t)want;
+    };
+
+    while (pos + (off_t)sizeof(ResultRecordHeader) <= file_size && ensure(sizeof(ResultRecordHeader))) {
+        ResultRecordHeader header;
+        memcpy(&header, buf.data() + (pos - buf_start), sizeof(header));
+        if (header.magic != RESULT_RECORD_MAGIC || header.finished < 0 || header.num_racers < 0) break;
+
+        size_t size = sizeof(header) + header.finished * (sizeof(int32_t) + sizeof(int64_t)) +
+                      header.num_racers * sizeof(int32_t) + sizeof(ResultRecordFooter);
+        if (pos + (off_t)size > file_size || !ensure(size)) break; // Record still being written
+
+        RaceResult result;
+        if (!decodeRecord(buf.data() + (pos - buf_start), size, result, nullptr)) break;
+        visit(result);
+        pos += size;
+    }
+    close(fd);
+    return pos;
+}
+
+/**
+ * @brief Loads the newest `count` results from the binary log (oldest first).
+ *        Reads only those records, so the cost does not grow with the log.
+ */
+bool loadRecentResults(size_t count, vector<RaceResult>& out) {
+    out.clear();
+    flushResultsLog();
+
+    int fd = open(RESULTS_LOG_FILE, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+
+    off_t end = lseek(fd, 0, SEEK_END);
+    while (out.size() < count) {
+        RaceResult result;
+        off_t start = readRecordEndingAt(fd, end, result, nullptr);
+        if (start < 0) break;
+        out.push_back(result);
+        end = start;
+    }
+    close(fd);
+
+    // Collected newest first
+    for (size_t i = 0, j = out.size(); i + 1 < j; ++i, --j) swap(out[i], out[j - 1]);
+    return true;
+}
+
+/**
+ * @brief Reads the whole-log aggregates from the last record's footer (O(1)).
+ */
+bool loadResultsAggregate(ResultsAggregate& totals) {
+    flushResultsLog(); // Other writers may have appended since, so the file is read either way
+
+    int fd = open(RESULTS_LOG_FILE, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return false;
+    RaceResult last;
+    totals = ResultsAggregate{};
+    readRecordEndingAt(fd, lseek(fd, 0, SEEK_END), last, &totals);
+    close(fd);
+    return true;
+}
+
+// ----------------------------------------------------------------------
+// --- RECENT RESULTS CACHE ---
+// ----------------------------------------------------------------------
+
+static void pushRecentLine(const string& line) {
+    recent_ring[recent_next] = line;
+    recent_next = (recent_next + 1) % RECENT_RESULTS_CAPACITY;
+    if (recent_count < RECENT_RESULTS_CAPACITY) recent_count++;
+}
+
+/**
+ * @brief (Re)fills the ring from the newest records of the log.
+ */
+static void seedRecentResults() {
+    recent_next = 0;
+    recent_count = 0;
+    recent_synced_offset = 0;
+
+    vector<RaceResult> results;
+    loadRecentResults(RECENT_RESULTS_CAPACITY, results); // Flushes our pending records first
+    for (const RaceResult& result : results) {
+        pushRecentLine(formatResultLine(result));
+    }
+
+    if (recent_fd == -1) {
+        recent_fd = open(RESULTS_LOG_FILE, O_RDONLY | O_CLOEXEC);
+    }
+    if (recent_fd != -1) {
+        struct stat st;
+        if (fstat(recent_fd, &st) == 0) recent_synced_offset = st.st_size;
+    }
+    recent_loaded = true;
+}
+
+/**
+ * @brief Decodes records another process appended after recent_synced_offset.
+ *        A shrunk or unparsable log falls back to reseeding from the tail.
+ */
+static void followLogAppends() {
+    if (recent_fd == -1) {
+        recent_fd = open(RESULTS_LOG_FILE, O_RDONLY | O_CLOEXEC);
+        if (recent_fd == -1) return;
+    }
+
+    struct stat st;
+    if (fstat(recent_fd, &st) != 0 || st.st_size == recent_synced_offset) return;
+    if (st.st_size < recent_synced_offset) {
+        seedRecentResults();
+        return;
+    }
+
+    vector<char> data(st.st_size - recent_synced_offset);
+    if (pread(recent_fd, data.data(), data.size(), recent_synced_offset) != (ssize_t)data.size()) return;
+
+    size_t offset = 0;
+    while (offset + sizeof(ResultRecordHeader) <= data.size()) {
+        ResultRecordHeader header;
+        memcpy(&header, data.data() + offset, sizeof(header));
+        if (header.magic != RESULT_RECORD_MAGIC || header.finished < 0 || header.num_racers < 0) {
+            seedRecentResults();
+            return;
+        }
+        size_t size = sizeof(header) + header.finished * (sizeof(int32_t) + sizeof(int64_t)) +
+                      header.num_racers * sizeof(int32_t) + sizeof(ResultRecordFooter);
+        if (offset + size > data.size()) break; // Record still being written
+
+        RaceResult result;
+        if (!decodeRecord(data.data() + offset, size, result, nullptr)) {
+            seedRecentResults();
+            return;
+        }
+        pushRecentLine(formatResultLine(result));
+        offset += size;
+    }
+    recent_synced_offset += offset;
+}
+
+/**
+ * @brief Returns the newest `count` result lines (oldest first) without rescanning the log.
+ */
+void recentResultLines(size_t count, vector<string>& out) {
+    if (!recent_loaded) {
+        seedRecentResults();
+    } else {
+        followLogAppends();
+    }
+
+    out.clear();
+    size_t n = count < recent_count ? count : recent_count;
+    for (size_t i = n; i > 0; --i) {
+        out.push_back(recent_ring[(recent_next + RECENT_RESULTS_CAPACITY - i) % RECENT_RESULTS_CAPACITY]);
+    }
+}
+
+// ----------------------------------------------------------------------
+// --- TEXT FORMAT ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief Formats a result the way race_results.txt has always shown it.
+ */
+string formatResultLine(const RaceResult& result) {
+    time_t when = (time_t)result.timestamp;
+    char dt[20];
+    strftime(dt, 20, "%Y-%m-%d %H:%M:%S", localtime(&when));
+
+    ostringstream line;
+    line << dt << " | Winner: Racer " << result.winner
+         << " | Duration: " << (double)result.duration_ms / 1000.0 << "s";
+    if (result.seed != 0) {
+        line << " | Seed: " << result.seed;
+    }
+    if (result.finish_order.size() > 1) {
+        line << " | Order:";
+        for (size_t i = 0; i < result.finish_order.size(); ++i) {
+            line << (i ? ", " : " ") << result.finish_order[i] << " ("
+                 << (double)result.finish_ms[i] / 1000.0 << "s)";
+        }
+    }
+    return line.str();
+}
+
+/**
+ * @brief Parses a legacy race_results.txt line ("date | Winner: Racer N | Duration: Xs").
+ */
+static bool parseResultLine(const string& line, RaceResult& result) {
+    struct tm tm = {};
+    int winner = 0;
+    double seconds = 0;
+    const char* rest = strptime(line.c_str(), "%Y-%m-%d %H:%M:%S", &tm);
+    if (rest == nullptr || sscanf(rest, " | Winner: Racer %d | Duration: %lfs", &winner, &seconds) != 2) {
+        return false;
+    }
+    tm.tm_isdst = -1;
+    result = RaceResult{};
+    result.timestamp = mktime(&tm);
+    result.duration_ms = (long)(seconds * 1000.0 + 0.5);
+    result.winner = winner;
+    if (winner > 0) {
+        result.finish_order.push_back(winner);
+        result.finish_ms.push_back(result.duration_ms);
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------
+// --- WRITING ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief Moves a log written in an older format aside (race_results.rlog.v<N>). The
+ *        new log is then rebuilt from race_results.txt, which holds the same history.
+ */
+static void retireOldLogVersion() {
+    int fd = open(RESULTS_LOG_FILE, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return;
+
+    ResultsFileHeader header;
+    bool old = pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+               header.magic == RESULTS_FILE_MAGIC && header.version < RESULTS_FILE_VERSION;
+    close(fd);
+    if (!old) return;
+
+    string aside = string(RESULTS_LOG_FILE) + ".v" + to_string(header.version);
+    if (rename(RESULTS_LOG_FILE, aside.c_str()) == 0) {
+        cerr << "Note: race_results.rlog has format version " << header.version << "; moved to " << aside
+             << " and rebuilding from race_results.txt." << endl;
+    }
+}
+
+/**
+ * @brief Opens (or creates) the results log for appending. A new log imports the
+ *        existing race_results.txt history; a torn final record is truncated away.
+ */
+bool openResultsLog() {
+    if (!LOG_RESULTS || results_fd != -1) return true;
+
+    retireOldLogVersion();
+    // O_APPEND keeps each record write atomic with respect to other writers
+    results_fd = open(RESULTS_LOG_FILE, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (results_fd == -1) {
+        perror("Could not open race_results.rlog");
+        return false;
+    }
+    // Another writer's record in progress is not a torn one: wait for it to land
+    flock(results_fd, LOCK_EX);
+
+    running_totals = ResultsAggregate{};
+    off_t size = lseek(results_fd, 0, SEEK_END);
+    if (size < (off_t)sizeof(ResultsFileHeader)) { // New (decided under the lock: one writer creates it)
+        ResultsFileHeader header = {RESULTS_FILE_MAGIC, RESULTS_FILE_VERSION, 0};
+        if (ftruncate(results_fd, 0) == -1 || pwrite(results_fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+            perror("Could not initialize race_results.rlog");
+            close(results_fd); // Releases the lock
+            results_fd = -1;
+            return false;
+        }
+
+        // Carry the existing text history over so the results view keeps it
+        ifstream legacy(RESULTS_TEXT_FILE);
+        string line;
+        RaceResult result;
+        while (getline(legacy, line)) {
+            if (parseResultLine(line, result)) {
+                pending.push_back(result);
+            }
+        }
+        results_end = sizeof(header);
+        flushResultsLog(); // Written before we give up the lock, ahead of any other writer's races
+    } else {
+        ResultsFileHeader header;
+        if (pread(results_fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+            header.magic != RESULTS_FILE_MAGIC || header.version != RESULTS_FILE_VERSION) {
+            cerr << "Error: race_results.rlog is not a results log (or has an unsupported version)." << endl;
+            close(results_fd); // Releases the lock
+            results_fd = -1;
+            return false;
+        }
+
+        RaceResult last;
+        if (size > (off_t)sizeof(header) && readRecordEndingAt(results_fd, size, last, &running_totals) < 0) {
+            off_t valid_end = findLastValidRecordEnd(results_fd, size, running_totals);
+            cerr << "Warning: dropping " << (size - valid_end) << " bytes of a torn record from race_results.rlog." << endl;
+            if (ftruncate(results_fd, valid_end) == -1) {
+                perror("ftruncate race_results.rlog failed");
+            }
+        }
+    }
+    results_end = lseek(results_fd, 0, SEEK_END);
+    flock(results_fd, LOCK_UN);
+
+    results_text.open(RESULTS_TEXT_FILE, ios::app);
+    if (!results_text.is_open()) {
+        cerr << "Error: Could not open race_results.txt for logging." << endl;
+    }
+    flushResultsLog();
+
+    // Whole-history analytics: loaded once here, then updated with every logged result
+    syncResultsAnalytics();
+    return true;
+}
+
+/**
+ * @brief Writes buffered records to race_results.rlog and flushes the text export.
+ */
+void flushResultsLog() {
+    if (results_fd != -1 && !pending.empty()) {
+        flock(results_fd, LOCK_EX);
+
+        // Our records are already in the recent-results ring; if nobody else appended
+        // since the ring was synced, just move the synced offset past what we write.
+        struct stat st;
+        off_t log_size = fstat(results_fd, &st) == 0 ? st.st_size : -1;
+        bool ring_in_sync = recent_loaded && log_size == recent_synced_offset;
+
+        // Another writer appended since our last write: continue from its footer
+        if (log_size != results_end) {
+            RaceResult last;
+            running_totals = ResultsAggregate{};
+            if (log_size > (off_t)sizeof(ResultsFileHeader) &&
+                readRecordEndingAt(results_fd, log_size, last, &running_totals) < 0) {
+                findLastValidRecordEnd(results_fd, log_size, running_totals);
+            }
+        }
+
+        vector<char> encoded;
+        encoded.reserve(pending_bytes);
+        for (const RaceResult& result : pending) {
+            addToTotals(running_totals, result);
+            encodeRecord(result, encoded);
+        }
+        pending.clear();
+        pending_bytes = 0;
+
+        size_t written = 0;
+        while (written < encoded.size()) {
+            ssize_t n = write(results_fd, encoded.data() + written, encoded.size() - written);
+            if (n <= 0) {
+                perror("write race_results.rlog failed");
+                break;
+            }
+            written += n;
+        }
+
+        off_t log_end = lseek(results_fd, 0, SEEK_END);
+        results_end = log_end;
+        flock(results_fd, LOCK_UN);
+        if (ring_in_sync) {
+            recent_synced_offset = log_end;
+        } else if (recent_loaded) {
+            recent_loaded = false; // Interleaved with another writer: reseed on next view
+        }
+        resultsAnalyticsFlushed(log_size, log_end);
+    }
+    if (results_text.is_open()) {
+        results_text.flush();
+    }
+}
+
+void closeResultsLog() {
+    flushResultsLog();
+    if (results_fd != -1) {
+        close(results_fd);
+        results_fd = -1;
+    }
+    if (results_text.is_open()) {
+        results_text.close();
+    }
+    if (recent_fd != -1) {
+        close(recent_fd);
+        recent_fd = -1;
+    }
+    recent_loaded = false;
+}
+
+/**
+ * @brief Logs a race result: one binary record plus the text line. Output is
+ *        buffered; call flushResultsLog() when the result must be on disk.
+ */
+void logRaceResult(const RaceResult& result) {
+    if (!LOG_RESULTS || results_fd == -1) return;
+
+    pending.push_back(result);
+    pending_bytes += sizeof(ResultRecordHeader) + result.finish_order.size() * (sizeof(int32_t) + sizeof(int64_t)) +
+                     result.steps.size() * sizeof(int32_t) + sizeof(ResultRecordFooter);
+    string line = formatResultLine(result);
+    if (results_text.is_open()) {
+        results_text << line << '\n';
+    }
+    if (recent_loaded) {
+        pushRecentLine(line);
+    }
+    foldIntoResultsAnalytics(result);
+
+    if (pending_bytes >= RESULTS_FLUSH_BYTES) {
+        flushResultsLog();
+    }
+}
+
+/**
+ * @brief Prints the newest `count` results and the whole-log aggregates (--results-tail).
+ */
+void printResultsTail(size_t count) {
+    vector<RaceResult> results;
+    ResultsAggregate totals;
+    if (!loadRecentResults(count, results) || !loadResultsAggregate(totals)) {
+        cerr << "No results log found (" << RESULTS_LOG_FILE << ")." << endl;
+        return;
+    }
+
+    for (const RaceResult& result : results) {
+        cout << formatResultLine(result) << "\n";
+    }
+    printf("Total races: %ld (%ld with a winner) | Mean duration: %.3fs | Min: %.3fs | Max: %.3fs\n",
+           totals.total_races, totals.timed_races,
+           totals.timed_races ? totals.total_duration_ms / 1000.0 / totals.timed_races : 0.0,
+           totals.min_duration_ms / 1000.0, totals.max_duration_ms / 1000.0);
+}
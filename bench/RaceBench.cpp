@@ -0,0 +1,304 @@
+// Benchmark suite for the race control path, with JSON output for tracking regressions.
+//
+//   startup          start_race_processes() latency and cleanup_children() teardown
+//                    time versus racer count, for the fork, prefork and thread backends
+//   step_throughput  racer steps/s through the shared segment with delays disabled
+//   log_append       logRaceResult() cost per record (plus the final flush)
+//
+// Build: cmake -S . -B build && cmake --build build --target race_bench
+// Usage: race_bench [--reps N] [--max-racers N] [--quick] [--out FILE]
+//
+// The JSON goes to stdout (or FILE); the library's own progress messages are
+// sent to stderr so the output stays parseable.
+
+#include "RaceLogic.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sched.h>
+#include <thread>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+#ifndef RACE_VERSION
+#define RACE_VERSION "unknown"
+#endif
+
+struct BenchOptions {
+    int reps = 20;
+    int max_racers = 256;
+    int step_length = 20000;
+    int log_records = 20000;
+    string out_path;
+};
+
+struct BackendCase {
+    const char* name;
+    int backend;
+    bool prefork;
+};
+
+const BackendCase BACKENDS[] = {
+    {"fork", BACKEND_FORK, false},
+    {"prefork", BACKEND_FORK, true},
+    {"thread", BACKEND_THREAD, false},
+};
+
+static double elapsedUs(chrono::steady_clock::time_point since) {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - since).count();
+}
+
+/**
+ * @brief Writes min/median/p90/mean/max of `samples` as a JSON object.
+ */
+static void writeSummary(FILE* out, vector<double> samples) {
+    if (samples.empty()) {
+        fprintf(out, "null");
+        return;
+    }
+    sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double s : samples) sum += s;
+    fprintf(out, "{\"min\": %.2f, \"median\": %.2f, \"p90\": %.2f, \"mean\": %.2f, \"max\": %.2f}",
+            samples.front(), samples[samples.size() / 2], samples[(samples.size() * 9) / 10],
+            sum / samples.size(), samples.back());
+}
+
+/**
+ * @brief Selects the backend and racer count and creates a fresh arena with its pool.
+ */
+static RaceShm* setUpRace(const BackendCase& backend, int racers, int length) {
+    RACE_BACKEND = backend.backend;
+    PREFORK = backend.prefork;
+    NUM_RACERS = racers;
+    RACE_LENGTH = length;
+    computeShmLayout();
+
+    RaceShm* shm = createRaceArena();
+    if (shm == nullptr) return nullptr;
+    if (!startRacerPool(shm)) {
+        setRaceStatus(shm, EXITING);
+        shutdownRacers(shm);
+        destroyRaceArena(shm);
+        return nullptr;
+    }
+    return shm;
+}
+
+static void tearDownRace(RaceShm* shm) {
+    setRaceStatus(shm, EXITING);
+    shutdownRacers(shm);
+    destroyRaceArena(shm);
+}
+
+// ----------------------------------------------------------------------
+// --- STARTUP / TEARDOWN ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief Racers are started and torn down without running: they park at READY, so
+ *        the numbers are pure process/thread start and stop cost.
+ */
+static void benchStartup(FILE* out, const BenchOptions& opts) {
+    fprintf(out, "  \"startup\": [\n");
+    bool first = true;
+    for (const BackendCase& backend : BACKENDS) {
+        for (int racers = 1; racers <= opts.max_racers; racers *= 4) {
+            auto pool_begin = chrono::steady_clock::now();
+            RaceShm* shm = setUpRace(backend, racers, 100);
+            if (shm == nullptr) continue;
+            double pool_us = elapsedUs(pool_begin);
+
+            vector<double> start_us, teardown_us;
+            for (int rep = 0; rep < opts.reps; ++rep) {
+                auto begin = chrono::steady_clock::now();
+                start_race_processes(shm);
+                start_us.push_back(elapsedUs(begin));
+
+                begin = chrono::steady_clock::now();
+                cleanup_children(shm);
+                teardown_us.push_back(elapsedUs(begin));
+            }
+            tearDownRace(shm);
+
+            fprintf(out, "%s    {\"backend\": \"%s\", \"racers\": %d, \"pool_start_us\": %.2f, \"start_us\": ",
+                    first ? "" : ",\n", backend.name, racers, pool_us);
+            writeSummary(out, start_us);
+            fprintf(out, ", \"teardown_us\": ");
+            writeSummary(out, teardown_us);
+            fprintf(out, "}");
+            first = false;
+        }
+    }
+    fprintf(out, "\n  ],\n");
+}
+
+// ----------------------------------------------------------------------
+// --- STEP THROUGHPUT ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief Full races with DELAY_SCALE = 0 and every racer finishing (podium 0):
+ *        racer steps per second of running time, start cost excluded.
+ */
+static void benchStepThroughput(FILE* out, const BenchOptions& opts) {
+    DELAY_SCALE = 0.0;
+    PODIUM_SIZE = 0;
+
+    fprintf(out, "  \"step_throughput\": [\n");
+    bool first = true;
+    for (const BackendCase& backend : BACKENDS) {
+        for (int racers : {4, 16}) {
+            if (racers > opts.max_racers) continue;
+            RaceShm* shm = setUpRace(backend, racers, opts.step_length);
+            if (shm == nullptr) continue;
+
+            long total_steps = 0;
+            double running_us = 0;
+            vector<double> steps_per_sec;
+            for (int rep = 0; rep < opts.reps; ++rep) {
+                start_race_processes(shm);
+                auto begin = chrono::steady_clock::now();
+                setRaceStatus(shm, RUNNING);
+                while (getRaceStatus(shm) == RUNNING) {
+                    sched_yield();
+                }
+                double race_us = elapsedUs(begin);
+
+                long steps = 0;
+                for (int i = 0; i < racers; ++i) steps += racerSlot(shm, i)->steps;
+                total_steps += steps;
+                running_us += race_us;
+                steps_per_sec.push_back(steps / (race_us / 1e6));
+            }
+            tearDownRace(shm);
+
+            fprintf(out, "%s    {\"backend\": \"%s\", \"racers\": %d, \"length\": %d, \"races\": %d, "
+                         "\"total_steps\": %ld, \"steps_per_sec\": %.0f, \"per_race_steps_per_sec\": ",
+                    first ? "" : ",\n", backend.name, racers, opts.step_length, opts.reps,
+                    total_steps, total_steps / (running_us / 1e6));
+            writeSummary(out, steps_per_sec);
+            fprintf(out, "}");
+            first = false;
+        }
+    }
+    fprintf(out, "\n  ],\n");
+    DELAY_SCALE = 1.0;
+    PODIUM_SIZE = 1;
+}
+
+// ----------------------------------------------------------------------
+// --- RESULTS LOG APPEND ---
+// ----------------------------------------------------------------------
+
+/**
+ * @brief Appends log_records results (16 racers each) to a fresh log in a temp directory.
+ */
+static void benchLogAppend(FILE* out, const BenchOptions& opts) {
+    char dir_template[] = "/tmp/race_bench_XXXXXX";
+    char* dir = mkdtemp(dir_template);
+    char old_cwd[PATH_MAX];
+    if (dir == nullptr || getcwd(old_cwd, sizeof(old_cwd)) == nullptr || chdir(dir) != 0) {
+        perror("log_append: temp dir");
+        fprintf(out, "  \"log_append\": null\n");
+        return;
+    }
+
+    LOG_RESULTS = true;
+    NUM_RACERS = 16;
+    openResultsLog();
+
+    RaceResult result = {};
+    result.timestamp = time(nullptr);
+    result.start_time_ms = result.timestamp * 1000;
+    result.seed = 42;
+    for (int i = 0; i < NUM_RACERS; ++i) {
+        result.finish_order.push_back(i + 1);
+        result.finish_ms.push_back(10000 + i * 37);
+        result.steps.push_back(40 + i);
+    }
+
+    vector<double> append_ns;
+    append_ns.reserve(opts.log_records);
+    auto all_begin = chrono::steady_clock::now();
+    for (int i = 0; i < opts.log_records; ++i) {
+        result.duration_ms = 10000 + i % 500;
+        result.winner = 1 + i % NUM_RACERS;
+        auto begin = chrono::steady_clock::now();
+        logRaceResult(result);
+        append_ns.push_back(elapsedUs(begin) * 1000.0);
+    }
+    auto flush_begin = chrono::steady_clock::now();
+    flushResultsLog();
+    double flush_us = elapsedUs(flush_begin);
+    double total_us = elapsedUs(all_begin);
+    closeResultsLog();
+
+    struct stat st = {};
+    stat("race_results.rlog", &st);
+    unlink("race_results.rlog");
+    unlink("race_results.txt");
+    unlink("race_results.stats");
+    if (chdir(old_cwd) != 0) perror("log_append: chdir back");
+    rmdir(dir);
+
+    fprintf(out, "  \"log_append\": {\"records\": %d, \"racers\": %d, \"bytes_per_record\": %.1f, "
+                 "\"records_per_sec\": %.0f, \"final_flush_us\": %.2f, \"append_ns\": ",
+            opts.log_records, NUM_RACERS, (double)st.st_size / opts.log_records,
+            opts.log_records / (total_us / 1e6), flush_us);
+    writeSummary(out, append_ns);
+    fprintf(out, "}\n");
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions opts;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--quick") {
+            opts.reps = 5;
+            opts.max_racers = 64;
+            opts.step_length = 5000;
+            opts.log_records = 5000;
+        } else if (arg == "--reps" && i + 1 < argc) {
+            opts.reps = max(1, atoi(argv[++i]));
+        } else if (arg == "--max-racers" && i + 1 < argc) {
+            opts.max_racers = min(MAX_RACERS, max(1, atoi(argv[++i])));
+        } else if (arg == "--out" && i + 1 < argc) {
+            opts.out_path = argv[++i];
+        } else {
+            cerr << "Usage: " << argv[0] << " [--reps N] [--max-racers N] [--quick] [--out FILE]\n";
+            return 1;
+        }
+    }
+
+    FILE* out = opts.out_path.empty() ? stdout : fopen(opts.out_path.c_str(), "w");
+    if (out == nullptr) {
+        perror("Could not open output file");
+        return 1;
+    }
+    // Library progress output ("Shared Memory ID ... removed", pool reports) goes to stderr
+    cout.rdbuf(cerr.rdbuf());
+
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    fprintf(out, "{\n  \"version\": \"%s\",\n  \"host\": \"%s\",\n  \"cpus\": %u,\n  \"timestamp\": %ld,\n  \"reps\": %d,\n",
+            RACE_VERSION, host, thread::hardware_concurrency(), (long)time(nullptr), opts.reps);
+
+    benchStartup(out, opts);
+    benchStepThroughput(out, opts);
+    benchLogAppend(out, opts);
+    fprintf(out, "}\n");
+
+    if (out != stdout) fclose(out);
+    return 0;
+}
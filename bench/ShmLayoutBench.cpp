@@ -0,0 +1,137 @@
+// Microbenchmark: packed int-array SHM layout (pre-v2) vs cache-line-aligned RaceShm/RacerSlot.
+//
+// Forks N writer processes that each bump their own position as fast as possible
+// while reading the shared status word (what a racer does every step), and lets
+// the parent scan every position (what the monitor does every frame). With the
+// packed layout 16 racers share each 64-byte line with each other and the status
+// word, so every write invalidates the line everyone else is reading; with one
+// slot per line only the owning core ever writes it. Higher writes/s and scans/s
+// = less coherence traffic.
+//
+// Build: cmake --build build --target shm_layout_bench
+//        (or: g++ -std=c++17 -O2 -I. bench/ShmLayoutBench.cpp -o shm_layout_bench)
+// Usage: shm_layout_bench [racers=64] [seconds=2]
+
+#include "RaceLogic.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+static volatile long bench_sink;
+
+struct BenchResult {
+    double writes_per_sec;
+    double scans_per_sec;
+};
+
+/**
+ * @brief Runs one layout. position(i) / status must point into MAP_SHARED memory.
+ */
+template <typename PositionOf>
+static BenchResult runLayout(int racers, double seconds, PositionOf position, int* status) {
+    // Per-writer iteration counts and the start/stop flag live outside the measured region
+    long* counts = (long*)mmap(nullptr, sizeof(long) * racers + CACHE_LINE_SIZE,
+                               PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (counts == MAP_FAILED) {
+        perror("mmap failed");
+        exit(1);
+    }
+    int* stop = (int*)(counts + racers);
+    *stop = 0;
+
+    __atomic_store_n(status, (int)READY, __ATOMIC_RELEASE);
+    for (int i = 0; i < racers; ++i) {
+        pid_t pid = fork();
+        if (pid == -1) {
+            perror("fork failed");
+            exit(1);
+        }
+        if (pid == 0) {
+            int* pos = position(i);
+            long iterations = 0;
+            while (__atomic_load_n(status, __ATOMIC_ACQUIRE) != RUNNING) {}
+            while (!__atomic_load_n(stop, __ATOMIC_RELAXED)) {
+                // A racer step: check the status word, publish the new position
+                if (__atomic_load_n(status, __ATOMIC_ACQUIRE) == RUNNING) {
+                    __atomic_store_n(pos, *pos + 1, __ATOMIC_RELEASE);
+                }
+                iterations++;
+            }
+            counts[i] = iterations;
+            _exit(0);
+        }
+    }
+
+    auto start = chrono::steady_clock::now();
+    __atomic_store_n(status, (int)RUNNING, __ATOMIC_RELEASE);
+
+    // Monitor: scan every racer's position until the time is up
+    long scans = 0;
+    long checksum = 0;
+    while (chrono::duration<double>(chrono::steady_clock::now() - start).count() < seconds) {
+        for (int i = 0; i < racers; ++i) {
+            checksum += __atomic_load_n(position(i), __ATOMIC_ACQUIRE);
+        }
+        scans++;
+    }
+    __atomic_store_n(stop, 1, __ATOMIC_RELAXED);
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    long writes = 0;
+    for (int i = 0; i < racers; ++i) {
+        wait(nullptr);
+    }
+    for (int i = 0; i < racers; ++i) {
+        writes += counts[i];
+    }
+    munmap(counts, sizeof(long) * racers + CACHE_LINE_SIZE);
+
+    bench_sink = checksum; // Keep the scan loop from being optimized away
+    return BenchResult{writes / elapsed, scans / elapsed};
+}
+
+int main(int argc, char* argv[]) {
+    int racers = argc > 1 ? atoi(argv[1]) : 64;
+    double seconds = argc > 2 ? atof(argv[2]) : 2.0;
+    if (racers < 1 || seconds <= 0) {
+        cerr << "Usage: " << argv[0] << " [racers=64] [seconds=2]" << endl;
+        return 1;
+    }
+
+    // --- Packed layout: positions[N] | pids[N] | status (the pre-v2 int array) ---
+    size_t packed_size = sizeof(int) * (racers * 2 + 1);
+    int* packed = (int*)mmap(nullptr, packed_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    // --- Versioned layout: RaceShm control block + one RacerSlot per cache line ---
+    size_t padded_size = raceShmSize(racers);
+    RaceShm* shm = (RaceShm*)mmap(nullptr, padded_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (packed == MAP_FAILED || shm == MAP_FAILED) {
+        perror("mmap failed");
+        return 1;
+    }
+    shm->num_racers = racers;
+
+    BenchResult packed_result = runLayout(racers, seconds,
+        [packed](int i) { return &packed[i]; }, &packed[racers * 2]);
+    BenchResult padded_result = runLayout(racers, seconds,
+        [shm](int i) { return &racerSlot(shm, i)->position; }, &shm->status);
+
+    printf("racers=%d seconds=%.1f cpus=%ld\n", racers, seconds, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-10s %16s %16s\n", "layout", "writes/s", "monitor scans/s");
+    printf("%-10s %16.0f %16.0f\n", "packed", packed_result.writes_per_sec, packed_result.scans_per_sec);
+    printf("%-10s %16.0f %16.0f\n", "slotted", padded_result.writes_per_sec, padded_result.scans_per_sec);
+    printf("speedup    %15.2fx %15.2fx\n",
+           padded_result.writes_per_sec / packed_result.writes_per_sec,
+           padded_result.scans_per_sec / packed_result.scans_per_sec);
+
+    munmap(packed, packed_size);
+    munmap(shm, padded_size);
+    return 0;
+}
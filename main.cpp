@@ -1,121 +1,136 @@
 #include "RaceLogic.h"
 #include <iostream>
-#include <sys/types.h>
-#include <sys/wait.h>
-#include <sys/shm.h>
 #include <cstdlib>
 #include <unistd.h>
-#include <vector>
-#include <signal.h>
 
 using namespace std;
 
-// Global vector to hold child PIDs
-vector<pid_t> children;
-
-/**
- * @brief Kills and cleans up all running racer child processes.
- * @param shmid Shared memory ID.
- */
-void cleanup_children(int shmid) {
-    if (children.empty()) return;
-
-    cout << "\nTerminating racer processes...\n";
-
-    for (pid_t child_pid : children) {
-        int status;
-        // Check if the child is still running (waitpid with WNOHANG)
-        if (waitpid(child_pid, &status, WNOHANG) == 0) {
-            // If running, kill it forcefully
-            if (kill(child_pid, SIGKILL) == 0) {
-                // Wait for the killed process to be reaped
-                waitpid(child_pid, &status, 0);
-            } else {
-                perror("kill failed");
-            }
-        }
-    }
-    children.clear();
-}
+int main(int argc, char* argv[]) {
+    // 0. Read racer count / race length (CLI or config file); this also sizes the SHM layout
+    ConfigResult config = configureRace(argc, argv);
+    if (config != CONFIG_RUN) {
+        return config == CONFIG_EXIT ? 0 : 1;
+    }
 
-/**
- * @brief Forks the racer processes. (Called by RaceLogic.cpp when 'S' is pressed)
- * @param shmid Shared memory ID.
- */
-void start_race_processes(int shmid) {
-    // 1. Cleanup any previous children first (if the user restarted before cleanup)
-    cleanup_children(shmid);
-
-    // 2. Re-initialize shared memory positions/PIDs before forking
-    int* shm_ptr = (int*)shmat(shmid, nullptr, 0);
-    if (shm_ptr == (int*)-1) {
-        perror("shmat failed during start_race_processes");
-        return;
-    }
-
-    // Clear old racer PIDs and positions
-    for (int i = 0; i < NUM_RACERS; ++i) {
-        shm_ptr[PID_OFFSET + i] = 0;
-        shm_ptr[POS_OFFSET + i] = 0;
-    }
-    shm_ptr[STATUS_INDEX] = READY; // Reset status before fork
-    shmdt(shm_ptr);
-
-    // 3. Fork new children
-    for (int i = 1; i <= NUM_RACERS; ++i) {
-        pid_t pid = fork();
-
-        if (pid == -1) {
-            perror("fork failed");
-            cleanup_shm(shmid);
-            exit(1);
-        }
-
-        if (pid == 0) {
-            // Child Process runs racer logic
-            runRacer(i, shmid);
-            exit(EXIT_SUCCESS);
-        } else {
-            // Parent Process stores child PID
-            children.push_back(pid);
-        }
+    // 0a. Pure simulation: no processes, shared memory or results log
+    if (SIMULATE_RACES > 0) {
+        runSimulation();
+        return 0;
+    }
+
+    // 0a'. Replay of a recorded trace: no racers either
+    if (!REPLAY_PATH.empty()) {
+        return runReplay();
+    }
+
+    // 0b. Results log (binary + text export); --results-tail and --analytics only read it
+    if (RESULTS_TAIL > 0) {
+        printResultsTail(RESULTS_TAIL);
+        return 0;
+    }
+    if (RESULTS_ANALYTICS) {
+        printResultsAnalytics();
+        return 0;
+    }
+    if (!openResultsLog()) {
+        return 1;
+    }
+
+    // 0c. Supervisor: reclaim segments leaked by crashed runs, then route SIGCHLD /
+    //     SIGINT / SIGTERM through a signalfd (before any racer inherits the mask)
+    removeStaleSegments();
+    if (!initSupervisor()) {
+        closeResultsLog();
+        return 1;
+    }
+
+    // 1. Create the race state: shared segment (fork backend, see --shm) or in-process arena (thread backend)
+    RaceShm* shm = createRaceArena();
+    if (shm == nullptr) {
+        return 1;
     }
-}
 
-int main() {
-    // 1. Create Shared Memory Segment
-    // SHM_SIZE is now correctly calculated and defined in RaceLogic.cpp
-    int shmid = shmget(IPC_PRIVATE, SHM_SIZE, IPC_CREAT | 0666);
-    if (shmid == -1) {
-        perror("shmget failed");
+    // 2. Racer -> monitor wakeups (inherited by every forked racer). A single headless race
+    //    waits on its status futex instead, unless it also serves --stats-socket;
+    //    concurrent headless races share the eventfd.
+    if ((!HEADLESS || CONCURRENT_RACES > 1 || !STATS_SOCKET.empty()) && !initRaceEvents()) {
+        destroyRaceArena(shm);
         return 1;
     }
 
-    // 2. Attach and Initialize Status to READY
-    int* shm_ptr = (int*)shmat(shmid, nullptr, 0);
-    if (shm_ptr == (int*)-1) {
-        perror("shmat failed during initialization");
-        cleanup_shm(shmid);
+    // 2'. Live stats export: listening before any racer is forked (they close their copies)
+    if (!STATS_SOCKET.empty() && !openStatsExport(STATS_SOCKET)) {
+        closeRaceEvents();
+        destroyRaceArena(shm);
         return 1;
     }
 
-    shm_ptr[STATUS_INDEX] = READY; // Initial state is READY
-    shmdt(shm_ptr);
+    // 2a. Step recorder (--record): racers fill rings in the segment, the monitor drains them
+    if (!RECORD_PATH.empty() && !openTraceRecorder(RECORD_PATH)) {
+        closeStatsExport();
+        closeRaceEvents();
+        destroyRaceArena(shm);
+        return 1;
+    }
+
+    cout << describeRaceArena() << ", ";
+    if (CONCURRENT_RACES > 1) cout << CONCURRENT_RACES << " races x ";
+    cout << NUM_RACERS << " racers, length " << RACE_LENGTH << ")\n";
+    if (schedulingConfigured()) {
+        cout << describeRacerScheduling() << "\n";
+    }
+    if (profilesConfigured()) {
+        cout << describeRacerProfiles() << "\n";
+    }
+    if (!STATS_SOCKET.empty()) {
+        cout << "Stats export: " << STATS_SOCKET << " (JSON lines)\n";
+    }
 
-    cout << "Shared Memory segment created with ID: " << shmid << "\n";
-    cout << "Starting TUI (Text User Interface)...\n";
+    // 2b. Pooled racers (thread backend or --prefork) are created once, up front
+    if (!startRacerPool(shm)) {
+        setRaceStatus(shm, EXITING);
+        shutdownRacers(shm);
+        closeStatsExport();
+        destroyRaceArena(shm);
+        return 1;
+    }
 
-    // 3. Start the GUI loop (Parent process handles GUI, state, and key inputs)
-    runDisplayParent(shmid);
+    if (TOURNAMENT_ENTRANTS > 0) {
+        // 3. Tournament: rounds of heats, no ncurses
+        runTournament(shm);
+        setRaceStatus(shm, EXITING);
+    } else if (HEADLESS) {
+        // 3. Batch mode: races back-to-back, no ncurses
+        runHeadless(shm);
+        setRaceStatus(shm, EXITING);
+    } else {
+        cout << "Starting TUI (Text User Interface)...\n";
+
+        // 3. Start the GUI loop (Parent process handles GUI, state, and key inputs)
+        runDisplayParent(shm);
+    }
 
-    // After GUI exits (STATUS_INDEX == EXITING):
+    // After GUI exits (status == EXITING):
 
-    // 4. Cleanup Child Processes
-    cleanup_children(shmid);
+    // 4. Cleanup racer processes / threads
+    if (activeRacerCount() > 0) {
+        cout << "\nTerminating racer processes...\n";
+    }
+    shutdownRacers(shm);
+    printRacerPoolReport(shm);
+    printSchedulingReport(shm);
+    closeTraceRecorder(shm);
+    if (!STATS_OUT.empty()) {
+        writeRaceStatsJson(shm, STATS_OUT);
+    }
 
     // 5. Cleanup Shared Memory
-    cleanup_shm(shmid);
+    closeStatsExport();
+    destroyRaceArena(shm);
+    closeRaceEvents();
+    closeResultsLog();
+    closeSupervisor();
 
     cout << "\nProgram finished.\n";
     return 0;
-}
\ No newline at end of file
+}